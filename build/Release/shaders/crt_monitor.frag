@@ -1,11 +1,9 @@
 #version 330 core
+#pragma frame_constants
 in vec2 TexCoord;
 out vec4 FragColor;
 
 uniform sampler2D screenTexture;
-uniform float time;
-uniform float screenWidth;
-uniform float screenHeight;
 
 void main() {
     vec2 uv = TexCoord;
@@ -19,7 +17,7 @@ void main() {
     color.g = texture(screenTexture, uv).g;
     color.b = texture(screenTexture, uv - vec2(separation, 0.0)).b;
     
-    float scanline = sin(uv.y * screenHeight * 2.0) * 0.1;
+    float scanline = sin(uv.y * screenSize.y * 2.0) * 0.1;
     color -= scanline;
     vec2 center = uv - 0.5;
     float vignette = 1.0 - dot(center, center) * 1.2;
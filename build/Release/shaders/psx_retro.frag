@@ -1,13 +1,9 @@
 #version 330 core
+#pragma frame_constants
 in vec2 TexCoord;
 out vec4 FragColor;
 
 uniform sampler2D screenTexture;
-uniform float time;
-uniform float screenWidth;
-uniform float screenHeight;
-uniform float renderWidth;
-uniform float renderHeight;
 
 uniform float scanlineIntensity = 0.8;
 uniform float scanlineFrequency = 2.0;
@@ -30,7 +26,7 @@ void main() {
     color = floor(color * 64.0) / 64.0;
     
     // Scanlines
-    float scanline = sin(uv.y * renderHeight * scanlineFrequency) * 0.04 * scanlineIntensity;
+    float scanline = sin(uv.y * renderSize.y * scanlineFrequency) * 0.04 * scanlineIntensity;
     color -= scanline;
     
     // Film grain
@@ -0,0 +1,228 @@
+#pragma once
+
+#include "model.h"
+#include "Texture.h"
+#include "Trace.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <deque>
+#include <vector>
+#include <string>
+#include <chrono>
+
+enum class AssetState {
+    Loading,    // queued or running on a worker
+    Uploading,  // CPU work done, waiting for the main thread to create GL objects
+    Ready,
+    Failed
+};
+
+// Shared between the caller, the worker and the upload queue; poll it like a future
+class AssetHandle {
+public:
+    AssetState GetState() const { return state.load(); }
+    bool IsReady() const { return state.load() == AssetState::Ready; }
+    bool IsDone() const {
+        AssetState s = state.load();
+        return s == AssetState::Ready || s == AssetState::Failed;
+    }
+    const std::string& GetPath() const { return path; }
+
+private:
+    friend class AssetLoader;
+    std::atomic<AssetState> state{AssetState::Loading};
+    std::string path;
+};
+
+// Loads assets on a pool of worker threads. Workers do file I/O, decoding and vertex
+// processing; the GL side is queued and run by ProcessUploads on the main thread.
+class AssetLoader {
+public:
+    AssetLoader() {}
+    ~AssetLoader() { Shutdown(); }
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    void Initialize(int threadCount = 0) {
+        if (!workers.empty()) return;
+
+        if (threadCount <= 0) {
+            int hardware = (int)std::thread::hardware_concurrency();
+            threadCount = hardware > 2 ? hardware - 1 : 1;
+        }
+
+        stopping = false;
+        for (int i = 0; i < threadCount; i++) {
+            workers.emplace_back(&AssetLoader::workerLoop, this, i);
+        }
+    }
+
+    // Stop the workers; loads that never ran and uploads that never ran are marked Failed so
+    // their handles still finish
+    void Shutdown() {
+        std::deque<Job> droppedJobs;
+        {
+            std::lock_guard<std::mutex> lock(jobMutex);
+            stopping = true;
+            droppedJobs.swap(jobs);
+        }
+        jobReady.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        workers.clear();
+
+        std::deque<Upload> droppedUploads;
+        {
+            std::lock_guard<std::mutex> lock(uploadMutex);
+            droppedUploads.swap(uploads);
+        }
+
+        for (auto& job : droppedJobs) {
+            job.handle->state = AssetState::Failed;
+            pendingCount--;
+        }
+        for (auto& upload : droppedUploads) {
+            upload.handle->state = AssetState::Failed;
+            pendingCount--;
+        }
+    }
+
+    // The model must stay alive until the handle is done
+    std::shared_ptr<AssetHandle> LoadModel(Model* model, const std::string& path) {
+        return submit(path,
+            [model, path]() { return model->LoadCPU(path); },
+            [model]() { model->UploadGPU(); });
+    }
+
+    // The texture must stay alive until the handle is done
+    std::shared_ptr<AssetHandle> LoadTexture(Texture* texture, const std::string& path) {
+        return submit(path,
+            [texture, path]() { return texture->LoadPixels(path); },
+            [texture]() { texture->Upload(); });
+    }
+
+    // Any other asset: load runs on a worker (return false on failure), upload runs on the
+    // main thread inside ProcessUploads once load has succeeded
+    std::shared_ptr<AssetHandle> Submit(const std::string& path, std::function<bool()> load, std::function<void()> upload) {
+        return submit(path, std::move(load), std::move(upload));
+    }
+
+    // Run queued GL uploads until budgetMs has been spent; at least one runs per call so
+    // progress is guaranteed. Returns the number of uploads completed.
+    int ProcessUploads(float budgetMs) {
+        auto start = std::chrono::steady_clock::now();
+        int completed = 0;
+
+        while (true) {
+            Upload upload;
+            {
+                std::lock_guard<std::mutex> lock(uploadMutex);
+                if (uploads.empty()) break;
+                upload = std::move(uploads.front());
+                uploads.pop_front();
+            }
+
+            {
+                TraceScope trace("Asset Upload");
+                upload.run();
+            }
+            upload.handle->state = AssetState::Ready;
+            pendingCount--;
+            completed++;
+
+            float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if (elapsedMs >= budgetMs) break;
+        }
+
+        return completed;
+    }
+
+    int GetPendingCount() const { return pendingCount.load(); }
+    bool IsIdle() const { return pendingCount.load() == 0; }
+
+private:
+    struct Job {
+        std::shared_ptr<AssetHandle> handle;
+        std::function<bool()> load;
+        std::function<void()> upload;
+    };
+
+    struct Upload {
+        std::shared_ptr<AssetHandle> handle;
+        std::function<void()> run;
+    };
+
+    std::vector<std::thread> workers;
+    std::deque<Job> jobs;
+    std::mutex jobMutex;
+    std::condition_variable jobReady;
+    bool stopping = false;
+
+    std::deque<Upload> uploads;
+    std::mutex uploadMutex;
+
+    // Submitted but not yet Ready/Failed
+    std::atomic<int> pendingCount{0};
+
+    std::shared_ptr<AssetHandle> submit(const std::string& path, std::function<bool()> load, std::function<void()> upload) {
+        auto handle = std::make_shared<AssetHandle>();
+        handle->path = path;
+        pendingCount++;
+
+        // Without workers (not initialized) load synchronously so callers still work
+        if (workers.empty()) {
+            if (load()) {
+                upload();
+                handle->state = AssetState::Ready;
+            } else {
+                handle->state = AssetState::Failed;
+            }
+            pendingCount--;
+            return handle;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(jobMutex);
+            jobs.push_back({handle, std::move(load), std::move(upload)});
+        }
+        jobReady.notify_one();
+        return handle;
+    }
+
+    void workerLoop(int index) {
+        TraceRecorder::Instance().SetThreadName("Asset Worker " + std::to_string(index));
+        
+        while (true) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(jobMutex);
+                jobReady.wait(lock, [this]() { return stopping || !jobs.empty(); });
+                if (stopping) return;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+
+            bool loaded;
+            {
+                TraceScope trace("Asset Load");
+                loaded = job.load();
+            }
+            
+            if (!loaded) {
+                job.handle->state = AssetState::Failed;
+                pendingCount--;
+                continue;
+            }
+
+            job.handle->state = AssetState::Uploading;
+            std::lock_guard<std::mutex> lock(uploadMutex);
+            uploads.push_back({job.handle, std::move(job.upload)});
+        }
+    }
+};
@@ -0,0 +1,391 @@
+#pragma once
+
+#include <vector>
+#include <cfloat>
+#include <cmath>
+#include "Frustum.h"
+#include "PsxMath.h"
+
+struct AABB {
+    float min[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+    float max[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+
+    void Grow(const AABB& other) {
+        for (int axis = 0; axis < 3; axis++) {
+            if (other.min[axis] < min[axis]) min[axis] = other.min[axis];
+            if (other.max[axis] > max[axis]) max[axis] = other.max[axis];
+        }
+    }
+
+    void GrowPoint(const float* point) {
+        for (int axis = 0; axis < 3; axis++) {
+            if (point[axis] < min[axis]) min[axis] = point[axis];
+            if (point[axis] > max[axis]) max[axis] = point[axis];
+        }
+    }
+
+    bool IsValid() const { return min[0] <= max[0]; }
+
+    float SurfaceArea() const {
+        if (!IsValid()) return 0.0f;
+        float dx = max[0] - min[0], dy = max[1] - min[1], dz = max[2] - min[2];
+        return 2.0f * (dx * dy + dy * dz + dz * dx);
+    }
+
+    bool Overlaps(const AABB& other) const {
+        for (int axis = 0; axis < 3; axis++) {
+            if (min[axis] > other.max[axis] || max[axis] < other.min[axis]) return false;
+        }
+        return true;
+    }
+
+    // Slab test; returns the entry distance along the ray (0 if the origin is inside)
+    bool IntersectRay(const float* origin, const float* invDir, float maxT, float& tHit) const {
+        float tMin = 0.0f, tMax = maxT;
+        for (int axis = 0; axis < 3; axis++) {
+            float t0 = (min[axis] - origin[axis]) * invDir[axis];
+            float t1 = (max[axis] - origin[axis]) * invDir[axis];
+            if (t0 > t1) { float temp = t0; t0 = t1; t1 = temp; }
+            if (t0 > tMin) tMin = t0;
+            if (t1 < tMax) tMax = t1;
+            if (tMin > tMax) return false;
+        }
+        tHit = tMin;
+        return true;
+    }
+};
+
+// World-space box of a local box under a column-major affine matrix
+inline AABB TransformAABB(const float* localMin, const float* localMax, const float* m) {
+    AABB result;
+    TransformAABB(localMin, localMax, m, result.min, result.max);
+    return result;
+}
+
+enum class FrustumTest {
+    OUTSIDE,
+    INTERSECT,
+    INSIDE
+};
+
+inline FrustumTest ClassifyAABB(const Frustum& frustum, const AABB& box) {
+    FrustumTest result = FrustumTest::INSIDE;
+    for (int i = 0; i < 6; i++) {
+        const float* plane = frustum.planes[i];
+        // Corner farthest along the plane normal, and the one opposite it
+        float px = plane[0] >= 0.0f ? box.max[0] : box.min[0];
+        float py = plane[1] >= 0.0f ? box.max[1] : box.min[1];
+        float pz = plane[2] >= 0.0f ? box.max[2] : box.min[2];
+        float nx = plane[0] >= 0.0f ? box.min[0] : box.max[0];
+        float ny = plane[1] >= 0.0f ? box.min[1] : box.max[1];
+        float nz = plane[2] >= 0.0f ? box.min[2] : box.max[2];
+
+        if (plane[0] * px + plane[1] * py + plane[2] * pz + plane[3] < 0.0f) return FrustumTest::OUTSIDE;
+        if (plane[0] * nx + plane[1] * ny + plane[2] * nz + plane[3] < 0.0f) result = FrustumTest::INTERSECT;
+    }
+
+    if (frustum.maxDistance > 0.0f) {
+        float nearSq = 0.0f, farSq = 0.0f;
+        for (int axis = 0; axis < 3; axis++) {
+            float o = frustum.origin[axis];
+            float nearest = o < box.min[axis] ? box.min[axis] : (o > box.max[axis] ? box.max[axis] : o);
+            float farthest = (o - box.min[axis]) > (box.max[axis] - o) ? box.min[axis] : box.max[axis];
+            nearSq += (nearest - o) * (nearest - o);
+            farSq += (farthest - o) * (farthest - o);
+        }
+        float limitSq = frustum.maxDistance * frustum.maxDistance;
+        if (nearSq > limitSq) return FrustumTest::OUTSIDE;
+        if (farSq > limitSq) result = FrustumTest::INTERSECT;
+    }
+    return result;
+}
+
+// Bounding volume hierarchy over item boxes (one item per scene object).
+// Built top-down with binned SAH; moved items are refit in place up to the root.
+class BVH {
+public:
+    struct Node {
+        AABB bounds;
+        int parent = -1;
+        int left = -1;      // right child is left + 1; -1 for leaves
+        int firstItem = 0;  // leaves only: range into itemOrder
+        int itemCount = 0;
+
+        bool IsLeaf() const { return left < 0; }
+    };
+
+    static const int MAX_LEAF_ITEMS = 4;
+    static const int BIN_COUNT = 12;
+
+    std::vector<Node> nodes;
+    std::vector<AABB> itemBounds;
+    std::vector<int> itemOrder;   // items grouped by leaf
+    std::vector<int> itemLeaf;    // item -> leaf node
+
+    void Build(const std::vector<AABB>& bounds) {
+        itemBounds = bounds;
+        int count = (int)bounds.size();
+        itemOrder.resize(count);
+        itemLeaf.assign(count, -1);
+        for (int i = 0; i < count; i++) itemOrder[i] = i;
+
+        nodes.clear();
+        if (count == 0) return;
+        nodes.reserve(count * 2);
+
+        centroids.resize(count);
+        for (int i = 0; i < count; i++) {
+            for (int axis = 0; axis < 3; axis++) {
+                centroids[i].c[axis] = (bounds[i].min[axis] + bounds[i].max[axis]) * 0.5f;
+            }
+        }
+
+        nodes.push_back(Node());
+        nodes[0].firstItem = 0;
+        nodes[0].itemCount = count;
+        subdivide(0);
+    }
+
+    int ItemCount() const { return (int)itemBounds.size(); }
+
+    // Update one item's box and enlarge/shrink its ancestors to match
+    void Refit(int item, const AABB& bounds) {
+        if (item < 0 || item >= (int)itemBounds.size()) return;
+        itemBounds[item] = bounds;
+
+        int node = itemLeaf[item];
+        while (node >= 0) {
+            Node& n = nodes[node];
+            AABB box;
+            if (n.IsLeaf()) {
+                for (int i = 0; i < n.itemCount; i++) box.Grow(itemBounds[itemOrder[n.firstItem + i]]);
+            } else {
+                box = nodes[n.left].bounds;
+                box.Grow(nodes[n.left + 1].bounds);
+            }
+            n.bounds = box;
+            node = n.parent;
+        }
+    }
+
+    // Items in nodes entirely inside go to inside; items in leaves straddling a plane go to partial
+    void QueryFrustum(const Frustum& frustum, std::vector<int>& inside, std::vector<int>& partial) const {
+        if (nodes.empty()) return;
+        std::vector<int>& stack = traversalStack;
+        stack.clear();
+        stack.push_back(0);
+        while (!stack.empty()) {
+            const Node& n = nodes[stack.back()];
+            stack.pop_back();
+            FrustumTest test = ClassifyAABB(frustum, n.bounds);
+            if (test == FrustumTest::OUTSIDE) continue;
+            if (test == FrustumTest::INSIDE) {
+                collectItems(n, inside);
+            } else if (n.IsLeaf()) {
+                collectItems(n, partial);
+            } else {
+                stack.push_back(n.left);
+                stack.push_back(n.left + 1);
+            }
+        }
+    }
+
+    // Closest item whose box the ray hits; returns -1 on a miss
+    int Raycast(const float* origin, const float* dir, float maxDistance, float& hitDistance) const {
+        if (nodes.empty()) return -1;
+        float invDir[3];
+        for (int axis = 0; axis < 3; axis++) {
+            invDir[axis] = dir[axis] != 0.0f ? 1.0f / dir[axis] : FLT_MAX;
+        }
+
+        int closest = -1;
+        float closestT = maxDistance;
+        std::vector<int>& stack = traversalStack;
+        stack.clear();
+        stack.push_back(0);
+        while (!stack.empty()) {
+            const Node& n = nodes[stack.back()];
+            stack.pop_back();
+            float t;
+            if (!n.bounds.IntersectRay(origin, invDir, closestT, t)) continue;
+
+            if (n.IsLeaf()) {
+                for (int i = 0; i < n.itemCount; i++) {
+                    int item = itemOrder[n.firstItem + i];
+                    if (itemBounds[item].IntersectRay(origin, invDir, closestT, t) && t < closestT) {
+                        closestT = t;
+                        closest = item;
+                    }
+                }
+            } else {
+                stack.push_back(n.left);
+                stack.push_back(n.left + 1);
+            }
+        }
+
+        hitDistance = closestT;
+        return closest;
+    }
+
+    void QueryOverlap(const AABB& box, std::vector<int>& out) const {
+        if (nodes.empty()) return;
+        std::vector<int>& stack = traversalStack;
+        stack.clear();
+        stack.push_back(0);
+        while (!stack.empty()) {
+            const Node& n = nodes[stack.back()];
+            stack.pop_back();
+            if (!n.bounds.Overlaps(box)) continue;
+            if (n.IsLeaf()) {
+                for (int i = 0; i < n.itemCount; i++) {
+                    int item = itemOrder[n.firstItem + i];
+                    if (itemBounds[item].Overlaps(box)) out.push_back(item);
+                }
+            } else {
+                stack.push_back(n.left);
+                stack.push_back(n.left + 1);
+            }
+        }
+    }
+
+private:
+    struct Centroid { float c[3]; };
+    std::vector<Centroid> centroids;
+    mutable std::vector<int> traversalStack;
+
+    void collectItems(const Node& n, std::vector<int>& out) const {
+        if (n.IsLeaf()) {
+            for (int i = 0; i < n.itemCount; i++) out.push_back(itemOrder[n.firstItem + i]);
+            return;
+        }
+        collectItems(nodes[n.left], out);
+        collectItems(nodes[n.left + 1], out);
+    }
+
+    void subdivide(int nodeIndex) {
+        int first = nodes[nodeIndex].firstItem;
+        int count = nodes[nodeIndex].itemCount;
+
+        AABB bounds, centroidBounds;
+        for (int i = 0; i < count; i++) {
+            int item = itemOrder[first + i];
+            bounds.Grow(itemBounds[item]);
+            centroidBounds.GrowPoint(centroids[item].c);
+        }
+        nodes[nodeIndex].bounds = bounds;
+
+        int splitAxis = -1;
+        int splitBin = 0;
+        if (count > MAX_LEAF_ITEMS) {
+            findSplit(first, count, centroidBounds, splitAxis, splitBin);
+        }
+
+        if (splitAxis < 0) {
+            makeLeaf(nodeIndex);
+            return;
+        }
+
+        // Partition items by bin on the chosen axis
+        float lo = centroidBounds.min[splitAxis];
+        float scale = BIN_COUNT / (centroidBounds.max[splitAxis] - lo);
+        int i = first, j = first + count - 1;
+        while (i <= j) {
+            int bin = binIndex(centroids[itemOrder[i]].c[splitAxis], lo, scale);
+            if (bin <= splitBin) {
+                i++;
+            } else {
+                int temp = itemOrder[i]; itemOrder[i] = itemOrder[j]; itemOrder[j] = temp;
+                j--;
+            }
+        }
+
+        int leftCount = i - first;
+        if (leftCount == 0 || leftCount == count) {
+            makeLeaf(nodeIndex);
+            return;
+        }
+
+        int left = (int)nodes.size();
+        nodes.push_back(Node());
+        nodes.push_back(Node());
+        nodes[left].parent = nodes[left + 1].parent = nodeIndex;
+        nodes[left].firstItem = first;
+        nodes[left].itemCount = leftCount;
+        nodes[left + 1].firstItem = i;
+        nodes[left + 1].itemCount = count - leftCount;
+        nodes[nodeIndex].left = left;
+        nodes[nodeIndex].itemCount = 0;
+
+        subdivide(left);
+        subdivide(left + 1);
+    }
+
+    void makeLeaf(int nodeIndex) {
+        Node& n = nodes[nodeIndex];
+        n.left = -1;
+        for (int i = 0; i < n.itemCount; i++) itemLeaf[itemOrder[n.firstItem + i]] = nodeIndex;
+    }
+
+    static int binIndex(float value, float lo, float scale) {
+        int bin = (int)((value - lo) * scale);
+        return bin < 0 ? 0 : (bin >= BIN_COUNT ? BIN_COUNT - 1 : bin);
+    }
+
+    // Binned SAH: pick the axis/bin boundary with the lowest cost, or -1 if a leaf is cheaper
+    void findSplit(int first, int count, const AABB& centroidBounds, int& bestAxis, int& bestBin) {
+        float leafCost = (float)count;
+        float bestCost = FLT_MAX;
+        float parentArea = 0.0f;
+        {
+            AABB parent;
+            for (int i = 0; i < count; i++) parent.Grow(itemBounds[itemOrder[first + i]]);
+            parentArea = parent.SurfaceArea();
+        }
+        if (parentArea <= 0.0f) parentArea = 1.0f; // flat or point-sized items still split by count
+
+        for (int axis = 0; axis < 3; axis++) {
+            float lo = centroidBounds.min[axis];
+            float extent = centroidBounds.max[axis] - lo;
+            if (extent <= 0.0f) continue;
+            float scale = BIN_COUNT / extent;
+
+            AABB binBounds[BIN_COUNT];
+            int binCounts[BIN_COUNT] = {0};
+            for (int i = 0; i < count; i++) {
+                int item = itemOrder[first + i];
+                int bin = binIndex(centroids[item].c[axis], lo, scale);
+                binBounds[bin].Grow(itemBounds[item]);
+                binCounts[bin]++;
+            }
+
+            // Sweep from the right to get suffix areas, then from the left to evaluate each split
+            float rightArea[BIN_COUNT];
+            int rightCount[BIN_COUNT];
+            AABB accum;
+            int accumCount = 0;
+            for (int b = BIN_COUNT - 1; b > 0; b--) {
+                accum.Grow(binBounds[b]);
+                accumCount += binCounts[b];
+                rightArea[b] = accum.SurfaceArea();
+                rightCount[b] = accumCount;
+            }
+
+            AABB leftBox;
+            int leftCount = 0;
+            for (int b = 0; b < BIN_COUNT - 1; b++) {
+                leftBox.Grow(binBounds[b]);
+                leftCount += binCounts[b];
+                if (leftCount == 0 || rightCount[b + 1] == 0) continue;
+                float cost = 0.125f + (leftCount * leftBox.SurfaceArea() + rightCount[b + 1] * rightArea[b + 1]) / parentArea;
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestBin = b;
+                }
+            }
+        }
+
+        // Oversized leaves are never acceptable, otherwise only split when it pays off
+        if (count <= MAX_LEAF_ITEMS * 4 && bestCost >= leafCost) bestAxis = -1;
+    }
+};
@@ -2,6 +2,7 @@
 
 #include <glad/glad.h>
 #include <cmath>
+#include "PsxMath.h"
 
 const float YAW = -90.0f;
 const float PITCH = 0.0f;
@@ -43,7 +44,7 @@ public:
             Position[1] + Front[1], 
             Position[2] + Front[2]
         };
-        lookAt(Position, center, Up, matrix);
+        Mat4LookAt(vec3(Position), vec3(center), vec3(Up)).Store(matrix);
     }
 
     void ProcessKeyboard(int direction, float deltaTime) {
@@ -87,49 +88,14 @@ public:
 
     void updateCameraVectors() {
         float front[3];
-        front[0] = cos(radians(Yaw)) * cos(radians(Pitch));
-        front[1] = sin(radians(Pitch));
-        front[2] = sin(radians(Yaw)) * cos(radians(Pitch));
-        normalize(front, Front);
+        front[0] = cos(Radians(Yaw)) * cos(Radians(Pitch));
+        front[1] = sin(Radians(Pitch));
+        front[2] = sin(Radians(Yaw)) * cos(Radians(Pitch));
+        Normalize3(front, Front);
         
-        cross(Front, WorldUp, Right);
-        normalize(Right, Right);
-        cross(Right, Front, Up);
-        normalize(Up, Up);
-    }
-
-private:
-    float radians(float degrees) {
-        return degrees * 3.14159265359f / 180.0f;
-    }
-
-    void normalize(float* vec, float* result) {
-        float length = sqrt(vec[0]*vec[0] + vec[1]*vec[1] + vec[2]*vec[2]);
-        result[0] = vec[0] / length;
-        result[1] = vec[1] / length;
-        result[2] = vec[2] / length;
-    }
-
-    void cross(float* a, float* b, float* result) {
-        result[0] = a[1] * b[2] - a[2] * b[1];
-        result[1] = a[2] * b[0] - a[0] * b[2];
-        result[2] = a[0] * b[1] - a[1] * b[0];
-    }
-
-    void lookAt(float* eye, float* center, float* up, float* result) {
-        float f[3] = {center[0] - eye[0], center[1] - eye[1], center[2] - eye[2]};
-        normalize(f, f);
-        
-        float s[3];
-        cross(f, up, s);
-        normalize(s, s);
-        
-        float u[3];
-        cross(s, f, u);
-
-        result[0] = s[0]; result[4] = s[1]; result[8] = s[2]; result[12] = -s[0]*eye[0] - s[1]*eye[1] - s[2]*eye[2];
-        result[1] = u[0]; result[5] = u[1]; result[9] = u[2]; result[13] = -u[0]*eye[0] - u[1]*eye[1] - u[2]*eye[2];
-        result[2] = -f[0]; result[6] = -f[1]; result[10] = -f[2]; result[14] = f[0]*eye[0] + f[1]*eye[1] + f[2]*eye[2];
-        result[3] = 0; result[7] = 0; result[11] = 0; result[15] = 1;
+        Cross3(Front, WorldUp, Right);
+        Normalize3(Right, Right);
+        Cross3(Right, Front, Up);
+        Normalize3(Up, Up);
     }
 };
\ No newline at end of file
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+
+// Load-time palette reduction for CLUT textures. Median cut over the image's distinct RGBA
+// colours: the box holding the most pixels with a real spread is split at its weighted median
+// along its widest channel until there are maxColors boxes; each box becomes one palette
+// entry at its pixel-weighted mean. Every distinct colour belongs to exactly one box, so
+// mapping pixels to indices is a lookup, not a nearest-colour search.
+
+// Expand 1-4 channel 8-bit pixels to RGBA8 (grey replicates into RGB, missing alpha is 255)
+inline void ExpandToRGBA(const unsigned char* pixels, int pixelCount, int channels, std::vector<uint8_t>& rgba) {
+    rgba.resize((size_t)pixelCount * 4);
+    for (int i = 0; i < pixelCount; i++) {
+        const unsigned char* in = pixels + (size_t)i * channels;
+        uint8_t* out = &rgba[(size_t)i * 4];
+        if (channels <= 2) {
+            out[0] = out[1] = out[2] = in[0];
+            out[3] = channels == 2 ? in[1] : 255;
+        } else {
+            out[0] = in[0];
+            out[1] = in[1];
+            out[2] = in[2];
+            out[3] = channels == 4 ? in[3] : 255;
+        }
+    }
+}
+
+// Reduce pixelCount RGBA8 pixels to at most maxColors (<= 256) palette entries. Writes one
+// index per pixel and palette as RGBA8 entries; returns the number of entries used.
+inline int QuantizeMedianCut(const uint8_t* rgba, int pixelCount, int maxColors,
+                             std::vector<uint8_t>& indices, std::vector<uint8_t>& palette) {
+    struct Color {
+        uint8_t c[4];
+        uint32_t count;
+    };
+
+    indices.clear();
+    palette.clear();
+    if (pixelCount <= 0 || maxColors <= 0) return 0;
+
+    auto packColor = [](const uint8_t* p) {
+        return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    };
+
+    // Histogram of distinct colours
+    std::unordered_map<uint32_t, uint32_t> colorIndex;
+    std::vector<Color> colors;
+    for (int i = 0; i < pixelCount; i++) {
+        const uint8_t* p = rgba + (size_t)i * 4;
+        auto inserted = colorIndex.emplace(packColor(p), (uint32_t)colors.size());
+        if (inserted.second) colors.push_back({{p[0], p[1], p[2], p[3]}, 0});
+        colors[inserted.first->second].count++;
+    }
+
+    struct Box {
+        size_t begin, end; // range in colors
+        uint32_t pixels;
+        int widestChannel;
+        int range;
+    };
+
+    auto measure = [&](Box& box) {
+        uint8_t low[4] = {255, 255, 255, 255}, high[4] = {0, 0, 0, 0};
+        box.pixels = 0;
+        for (size_t i = box.begin; i < box.end; i++) {
+            for (int ch = 0; ch < 4; ch++) {
+                low[ch] = std::min(low[ch], colors[i].c[ch]);
+                high[ch] = std::max(high[ch], colors[i].c[ch]);
+            }
+            box.pixels += colors[i].count;
+        }
+        box.widestChannel = 0;
+        box.range = 0;
+        for (int ch = 0; ch < 4; ch++) {
+            if (high[ch] - low[ch] > box.range) {
+                box.range = high[ch] - low[ch];
+                box.widestChannel = ch;
+            }
+        }
+    };
+
+    std::vector<Box> boxes;
+    Box all = {0, colors.size(), 0, 0, 0};
+    measure(all);
+    boxes.push_back(all);
+
+    while ((int)boxes.size() < maxColors) {
+        // Split where it buys the most: many pixels spread over a wide range
+        int best = -1;
+        uint64_t bestScore = 0;
+        for (size_t b = 0; b < boxes.size(); b++) {
+            if (boxes[b].end - boxes[b].begin < 2 || boxes[b].range == 0) continue;
+            uint64_t score = (uint64_t)boxes[b].pixels * (uint64_t)boxes[b].range;
+            if (score > bestScore) {
+                bestScore = score;
+                best = (int)b;
+            }
+        }
+        if (best < 0) break;
+
+        Box box = boxes[best];
+        int ch = box.widestChannel;
+        std::sort(colors.begin() + box.begin, colors.begin() + box.end,
+                  [ch](const Color& a, const Color& b) { return a.c[ch] < b.c[ch]; });
+
+        // Weighted median, kept off the ends so both halves are non-empty
+        uint32_t half = box.pixels / 2, running = 0;
+        size_t split = box.begin + 1;
+        for (size_t i = box.begin; i < box.end - 1; i++) {
+            running += colors[i].count;
+            split = i + 1;
+            if (running >= half) break;
+        }
+
+        Box low = {box.begin, split, 0, 0, 0};
+        Box high = {split, box.end, 0, 0, 0};
+        measure(low);
+        measure(high);
+        boxes[best] = low;
+        boxes.push_back(high);
+    }
+
+    palette.assign(boxes.size() * 4, 0);
+    for (size_t b = 0; b < boxes.size(); b++) {
+        uint64_t sum[4] = {0, 0, 0, 0};
+        for (size_t i = boxes[b].begin; i < boxes[b].end; i++) {
+            for (int ch = 0; ch < 4; ch++) sum[ch] += (uint64_t)colors[i].c[ch] * colors[i].count;
+            colorIndex[packColor(colors[i].c)] = (uint32_t)b;
+        }
+        for (int ch = 0; ch < 4; ch++) {
+            palette[b * 4 + ch] = (uint8_t)((sum[ch] + boxes[b].pixels / 2) / boxes[b].pixels);
+        }
+    }
+
+    indices.resize(pixelCount);
+    for (int i = 0; i < pixelCount; i++) {
+        indices[i] = (uint8_t)colorIndex[packColor(rgba + (size_t)i * 4)];
+    }
+    return (int)boxes.size();
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <filesystem>
+#include <system_error>
+
+// .psxmesh: a cooked copy of an imported model, laid out so the loader can map the file
+// and pass the vertex/index blobs to glBufferData without touching them.
+//
+//   PsxMeshHeader
+//   PsxMeshSubmesh[submeshCount]
+//   PsxMeshLod[lodCount]
+//   vertex blob (vertexCount * vertexStride bytes, 16-byte aligned)
+//   index blob  (indexCount * indexSize bytes, 16-byte aligned; indexSize is 2 or 4)
+const uint32_t PSXMESH_MAGIC = 0x4D585350; // "PSXM"
+const uint32_t PSXMESH_VERSION = 4; // 4: LOD table
+const uint32_t PSXMESH_MAX_LODS = 4; // the renderer's per-level tables and queue keys are sized for this
+
+struct PsxMeshHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertexStride;
+    uint32_t indexSize;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t submeshCount;
+    uint32_t lodCount;
+    float boundsMin[3];
+    float boundsRadius;
+    float boundsMax[3];
+    float acmrSource;    // FIFO-16 cache miss ratio of the importer's triangle order
+    float boundsCenter[3];
+    float acmrOptimized; // and after OptimizeModelMesh
+    uint64_t submeshOffset;
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    uint64_t fileSize;
+};
+
+// Range of the shared index buffer belonging to one source mesh (indices are already rebased)
+struct PsxMeshSubmesh {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    uint32_t firstVertex;
+    uint32_t vertexCount;
+};
+
+// Index range of one level of detail; level 0 is the full mesh, each level after it roughly
+// halves the triangle count. Ranges cover every submesh and index the same vertices.
+struct PsxMeshLod {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+};
+
+static_assert(sizeof(PsxMeshHeader) == 112, "PsxMeshHeader layout is part of the file format");
+static_assert(sizeof(PsxMeshSubmesh) == 16, "PsxMeshSubmesh layout is part of the file format");
+static_assert(sizeof(PsxMeshLod) == 8, "PsxMeshLod layout is part of the file format");
+
+inline uint64_t AlignCookedOffset(uint64_t offset) {
+    return (offset + 15) & ~uint64_t(15);
+}
+
+// assets/GLB/bed.glb -> assets/GLB/bed.psxmesh
+inline std::string CookedMeshPath(const std::string& sourcePath) {
+    std::filesystem::path path(sourcePath);
+    path.replace_extension(".psxmesh");
+    return path.string();
+}
+
+// True when the cooked file is missing or older than its source
+inline bool CookedMeshIsStale(const std::string& sourcePath, const std::string& cookedPath) {
+    std::error_code ec;
+    auto cookedTime = std::filesystem::last_write_time(cookedPath, ec);
+    if (ec) return true;
+    auto sourceTime = std::filesystem::last_write_time(sourcePath, ec);
+    if (ec) return false; // source not shipped, the cooked copy is all we have
+    return sourceTime > cookedTime;
+}
+
+// Check that a mapped file is a .psxmesh this build understands, that every blob and table
+// entry is in range and that no index points past the vertices. Reads every index, so run it
+// off the main thread with the rest of LoadCPU
+inline const PsxMeshHeader* ValidateCookedMesh(const unsigned char* data, size_t size, uint32_t vertexStride) {
+    if (size < sizeof(PsxMeshHeader)) return nullptr;
+
+    const PsxMeshHeader* header = (const PsxMeshHeader*)data;
+    if (header->magic != PSXMESH_MAGIC || header->version != PSXMESH_VERSION) return nullptr;
+    if (header->vertexStride != vertexStride) return nullptr;
+    if (header->indexSize != 2 && header->indexSize != 4) return nullptr;
+    uint32_t indexSize = header->indexSize;
+    if (header->fileSize != size) return nullptr;
+
+    uint64_t submeshEnd = header->submeshOffset + uint64_t(header->submeshCount) * sizeof(PsxMeshSubmesh);
+    uint64_t lodEnd = submeshEnd + uint64_t(header->lodCount) * sizeof(PsxMeshLod);
+    uint64_t vertexEnd = header->vertexOffset + uint64_t(header->vertexCount) * vertexStride;
+    uint64_t indexEnd = header->indexOffset + uint64_t(header->indexCount) * indexSize;
+    if (submeshEnd > size || lodEnd > header->vertexOffset || vertexEnd > size || indexEnd > size) return nullptr;
+    if (header->indexOffset % indexSize != 0) return nullptr;
+
+    const PsxMeshSubmesh* submeshes = (const PsxMeshSubmesh*)(data + header->submeshOffset);
+    for (uint32_t i = 0; i < header->submeshCount; i++) {
+        if (uint64_t(submeshes[i].firstIndex) + submeshes[i].indexCount > header->indexCount) return nullptr;
+        if (uint64_t(submeshes[i].firstVertex) + submeshes[i].vertexCount > header->vertexCount) return nullptr;
+    }
+
+    // Every index goes straight to glDrawElementsBaseVertex, so none may point past the vertices
+    const unsigned char* indexData = data + header->indexOffset;
+    for (uint32_t i = 0; i < header->indexCount; i++) {
+        uint32_t index = indexSize == 2 ? ((const uint16_t*)indexData)[i] : ((const uint32_t*)indexData)[i];
+        if (index >= header->vertexCount) return nullptr;
+    }
+
+    // Level 0 is the full mesh: exactly the indices the submesh table covers
+    if (header->lodCount == 0 || header->lodCount > PSXMESH_MAX_LODS) return nullptr;
+    uint64_t fullIndexCount = 0;
+    for (uint32_t i = 0; i < header->submeshCount; i++) fullIndexCount += submeshes[i].indexCount;
+    const PsxMeshLod* lods = (const PsxMeshLod*)(data + submeshEnd);
+    if (lods[0].firstIndex != 0 || lods[0].indexCount != fullIndexCount) return nullptr;
+    for (uint32_t i = 0; i < header->lodCount; i++) {
+        if (lods[i].indexCount == 0 || lods[i].indexCount % 3 != 0) return nullptr;
+        if (uint64_t(lods[i].firstIndex) + lods[i].indexCount > header->indexCount) return nullptr;
+    }
+
+    return header;
+}
+
+// Write a cooked mesh. The header's offsets, counts and sizes are filled in here;
+// the caller provides bounds and stride/index size.
+inline bool WriteCookedMesh(const std::string& path, PsxMeshHeader header, const PsxMeshSubmesh* submeshes,
+                            const PsxMeshLod* lods, const void* vertexData, const void* indexData) {
+    header.magic = PSXMESH_MAGIC;
+    header.version = PSXMESH_VERSION;
+    header.submeshOffset = sizeof(PsxMeshHeader);
+    uint64_t lodOffset = header.submeshOffset + uint64_t(header.submeshCount) * sizeof(PsxMeshSubmesh);
+    header.vertexOffset = AlignCookedOffset(lodOffset + uint64_t(header.lodCount) * sizeof(PsxMeshLod));
+    header.indexOffset = AlignCookedOffset(header.vertexOffset + uint64_t(header.vertexCount) * header.vertexStride);
+    header.fileSize = header.indexOffset + uint64_t(header.indexCount) * header.indexSize;
+
+    // Write to a temporary name first so a crash never leaves a truncated file behind
+    std::string tempPath = path + ".tmp";
+    FILE* file = fopen(tempPath.c_str(), "wb");
+    if (!file) return false;
+
+    static const unsigned char zeros[16] = {};
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    if (ok && header.submeshCount > 0) {
+        ok = fwrite(submeshes, sizeof(PsxMeshSubmesh), header.submeshCount, file) == header.submeshCount;
+    }
+
+    if (ok && header.lodCount > 0) {
+        ok = fwrite(lods, sizeof(PsxMeshLod), header.lodCount, file) == header.lodCount;
+    }
+
+    uint64_t written = lodOffset + uint64_t(header.lodCount) * sizeof(PsxMeshLod);
+    if (ok) ok = fwrite(zeros, 1, header.vertexOffset - written, file) == header.vertexOffset - written;
+    if (ok) ok = fwrite(vertexData, header.vertexStride, header.vertexCount, file) == header.vertexCount;
+
+    written = header.vertexOffset + uint64_t(header.vertexCount) * header.vertexStride;
+    if (ok) ok = fwrite(zeros, 1, header.indexOffset - written, file) == header.indexOffset - written;
+    if (ok) ok = fwrite(indexData, header.indexSize, header.indexCount, file) == header.indexCount;
+
+    ok = (fclose(file) == 0) && ok;
+    if (!ok) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+// Uniform buffer binding point shared by every program that declares the FrameConstants block
+const unsigned int FRAME_CONSTANTS_BINDING = 0;
+
+// GLSL declaration, spliced into shader sources right after the #version line.
+// Member names match the loose uniforms they replaced so shader bodies read the same.
+const char* const FRAME_CONSTANTS_GLSL = R"(
+            layout (std140) uniform FrameConstants {
+                mat4 view;
+                mat4 projection;
+                vec3 cameraPos;
+                float time;
+                float fogStart;
+                float fogEnd;
+                float fogHeightStart;
+                float fogHeightEnd;
+                vec3 fogColor;
+                float u_snapResolution;
+                vec3 spotlightPos;
+                bool spotlightEnabled;
+                vec3 spotlightDir;
+                float spotlightRange;
+                vec3 spotlightColor;
+                float spotlightIntensity;
+                float spotlightInnerCone;
+                float spotlightOuterCone;
+                bool directionalEnabled;
+                float directionalIntensity;
+                vec3 directionalDir;
+                float ambientIntensity;
+                vec3 directionalColor;
+                vec3 ambientColor;
+                vec2 screenSize;
+                vec2 renderSize;
+            };
+)";
+
+// Shader files can't see FRAME_CONSTANTS_GLSL, so they ask for it with a
+// "#pragma frame_constants" line that Shader replaces with the declaration on load
+const char* const FRAME_CONSTANTS_PRAGMA = "#pragma frame_constants";
+
+inline std::string ExpandFrameConstants(const std::string& source) {
+    size_t at = source.find(FRAME_CONSTANTS_PRAGMA);
+    if (at == std::string::npos) return source;
+    return source.substr(0, at) + FRAME_CONSTANTS_GLSL + source.substr(at + strlen(FRAME_CONSTANTS_PRAGMA));
+}
+
+// CPU mirror of the std140 layout above (vec3 takes 16 bytes unless a scalar fills its last slot)
+struct FrameConstants {
+    float view[16];
+    float projection[16];
+    float cameraPos[3];
+    float time;
+    float fogStart;
+    float fogEnd;
+    float fogHeightStart;
+    float fogHeightEnd;
+    float fogColor[3];
+    float snapResolution;
+    float spotlightPos[3];
+    int spotlightEnabled;
+    float spotlightDir[3];
+    float spotlightRange;
+    float spotlightColor[3];
+    float spotlightIntensity;
+    float spotlightInnerCone;
+    float spotlightOuterCone;
+    int directionalEnabled;
+    float directionalIntensity;
+    float directionalDir[3];
+    float ambientIntensity;
+    float directionalColor[3];
+    float pad0;
+    float ambientColor[3];
+    float pad1;
+    float screenSize[2];
+    float renderSize[2];
+};
+
+static_assert(offsetof(FrameConstants, cameraPos) == 128, "FrameConstants must follow std140");
+static_assert(offsetof(FrameConstants, spotlightPos) == 176, "FrameConstants must follow std140");
+static_assert(offsetof(FrameConstants, ambientColor) == 272, "FrameConstants must follow std140");
+static_assert(sizeof(FrameConstants) == 304, "FrameConstants must follow std140");
+
+class FrameConstantsBuffer {
+public:
+    unsigned int UBO;
+    FrameConstants data;
+
+    FrameConstantsBuffer() : UBO(0), data() {}
+
+    void Initialize() {
+        glGenBuffers(1, &UBO);
+        glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameConstants), NULL, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_CONSTANTS_BINDING, UBO);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    // Push the whole block in one call
+    void Upload() {
+        Upload(data);
+    }
+
+    // Upload a different set of constants (e.g. the editor viewport) without touching the frame's copy
+    void Upload(const FrameConstants& constants) {
+        glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameConstants), &constants);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    // Screen size is only known when presenting, so it gets its own small update before the
+    // post-process pass reads it
+    void UploadScreenSize(float screenWidth, float screenHeight) {
+        data.screenSize[0] = screenWidth;
+        data.screenSize[1] = screenHeight;
+        glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+        glBufferSubData(GL_UNIFORM_BUFFER, offsetof(FrameConstants, screenSize), sizeof(data.screenSize), data.screenSize);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    ~FrameConstantsBuffer() {
+        if (UBO) glDeleteBuffers(1, &UBO);
+    }
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cmath>
+#include "PsxMath.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define PSX_FRUSTUM_SSE 1
+#endif
+
+// Six clip planes (ax + by + cz + d >= 0 is inside) plus an optional distance cutoff,
+// used to reject objects that are off screen or fully swallowed by fog.
+class Frustum {
+public:
+    float planes[6][4];
+    float origin[3] = {0.0f, 0.0f, 0.0f};
+    float maxDistance = 0.0f; // 0 disables the distance test
+
+    // Extract the planes from projection * view (both column-major, as uploaded to GL)
+    void Build(const float* view, const float* projection) {
+        mat4 clip = Mat4Multiply(mat4::Load(projection), mat4::Load(view));
+        const float* m = clip.m;
+
+        for (int i = 0; i < 3; i++) {
+            for (int c = 0; c < 4; c++) {
+                planes[i * 2 + 0][c] = m[c * 4 + 3] + m[c * 4 + i];
+                planes[i * 2 + 1][c] = m[c * 4 + 3] - m[c * 4 + i];
+            }
+        }
+
+        for (int i = 0; i < 6; i++) {
+            float length = sqrt(planes[i][0] * planes[i][0] + planes[i][1] * planes[i][1] + planes[i][2] * planes[i][2]);
+            if (length > 0.0f) {
+                for (int c = 0; c < 4; c++) planes[i][c] /= length;
+            }
+        }
+    }
+
+    void SetDistanceCutoff(const float* eye, float distance) {
+        origin[0] = eye[0];
+        origin[1] = eye[1];
+        origin[2] = eye[2];
+        maxDistance = distance;
+    }
+
+    bool TestSphere(float x, float y, float z, float radius) const {
+        for (int i = 0; i < 6; i++) {
+            if (planes[i][0] * x + planes[i][1] * y + planes[i][2] * z + planes[i][3] < -radius) return false;
+        }
+        if (maxDistance > 0.0f) {
+            float dx = x - origin[0], dy = y - origin[1], dz = z - origin[2];
+            float reach = maxDistance + radius;
+            if (dx * dx + dy * dy + dz * dz > reach * reach) return false;
+        }
+        return true;
+    }
+
+    // Test packed bounding spheres (structure of arrays), writing 1/0 per sphere into visible.
+    // Returns the number of visible spheres.
+    int CullSpheres(const float* xs, const float* ys, const float* zs, const float* radii, int count, unsigned char* visible) const {
+        int visibleCount = 0;
+        int i = 0;
+
+#ifdef PSX_FRUSTUM_SSE
+        __m128 planeA[6], planeB[6], planeC[6], planeD[6];
+        for (int p = 0; p < 6; p++) {
+            planeA[p] = _mm_set1_ps(planes[p][0]);
+            planeB[p] = _mm_set1_ps(planes[p][1]);
+            planeC[p] = _mm_set1_ps(planes[p][2]);
+            planeD[p] = _mm_set1_ps(planes[p][3]);
+        }
+        const __m128 ox = _mm_set1_ps(origin[0]);
+        const __m128 oy = _mm_set1_ps(origin[1]);
+        const __m128 oz = _mm_set1_ps(origin[2]);
+        const __m128 cutoff = _mm_set1_ps(maxDistance);
+        const bool useDistance = maxDistance > 0.0f;
+
+        for (; i + 4 <= count; i += 4) {
+            __m128 x = _mm_loadu_ps(xs + i);
+            __m128 y = _mm_loadu_ps(ys + i);
+            __m128 z = _mm_loadu_ps(zs + i);
+            __m128 r = _mm_loadu_ps(radii + i);
+            __m128 negR = _mm_sub_ps(_mm_setzero_ps(), r);
+
+            __m128 inside = _mm_cmpeq_ps(r, r); // all ones
+            for (int p = 0; p < 6; p++) {
+                __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeA[p], x), _mm_mul_ps(planeB[p], y)),
+                                      _mm_add_ps(_mm_mul_ps(planeC[p], z), planeD[p]));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(d, negR));
+            }
+
+            if (useDistance) {
+                __m128 dx = _mm_sub_ps(x, ox);
+                __m128 dy = _mm_sub_ps(y, oy);
+                __m128 dz = _mm_sub_ps(z, oz);
+                __m128 distSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+                __m128 reach = _mm_add_ps(cutoff, r);
+                inside = _mm_and_ps(inside, _mm_cmple_ps(distSq, _mm_mul_ps(reach, reach)));
+            }
+
+            int mask = _mm_movemask_ps(inside);
+            for (int lane = 0; lane < 4; lane++) {
+                visible[i + lane] = (mask >> lane) & 1;
+                visibleCount += visible[i + lane];
+            }
+        }
+#endif
+
+        for (; i < count; i++) {
+            visible[i] = TestSphere(xs[i], ys[i], zs[i], radii[i]) ? 1 : 0;
+            visibleCount += visible[i];
+        }
+
+        return visibleCount;
+    }
+};
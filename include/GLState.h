@@ -0,0 +1,191 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// Shadow copy of the GL state the renderer touches. Every change goes through here and is
+// dropped when the value is already current, so passes can state what they need without
+// paying for what is already set. Code that changes state behind its back (third-party
+// renderers) must call Invalidate() afterwards.
+class GLState {
+public:
+    static const int MAX_TEXTURE_UNITS = 16;
+
+    // Calls forwarded to GL and calls dropped as redundant, reset by ResetStats()
+    struct Stats {
+        int issued = 0;
+        int skipped = 0;
+    };
+
+    Stats stats;
+
+    static GLState& Instance() {
+        static GLState instance;
+        return instance;
+    }
+
+    void ResetStats() {
+        stats = Stats();
+    }
+
+    // Forget everything; the next call of each kind always reaches GL
+    void Invalidate() {
+        program = UNKNOWN;
+        vertexArray = UNKNOWN;
+        framebuffer = UNKNOWN;
+        activeUnit = UNKNOWN;
+        for (int unit = 0; unit < MAX_TEXTURE_UNITS; unit++) {
+            for (int target = 0; target < TEXTURE_TARGETS; target++) {
+                textures[unit][target] = UNKNOWN;
+            }
+        }
+        viewport[0] = viewport[1] = viewport[2] = viewport[3] = -1;
+        blend = depthTest = cullFace = depthMask = -1;
+        blendSrc = blendDst = depthFunc = cullMode = UNKNOWN;
+    }
+
+    void UseProgram(GLuint id) {
+        if (!changed(program, id)) return;
+        glUseProgram(id);
+    }
+
+    void BindVertexArray(GLuint id) {
+        if (!changed(vertexArray, id)) return;
+        glBindVertexArray(id);
+    }
+
+    void BindFramebuffer(GLuint id) {
+        if (!changed(framebuffer, id)) return;
+        glBindFramebuffer(GL_FRAMEBUFFER, id);
+    }
+
+    void BindTexture(GLuint unit, GLenum target, GLuint id) {
+        int index = targetIndex(target);
+        if (unit >= (GLuint)MAX_TEXTURE_UNITS || index < 0) {
+            setActiveUnit(unit);
+            glBindTexture(target, id);
+            stats.issued++;
+            return;
+        }
+        if (!changed(textures[unit][index], id)) return;
+        setActiveUnit(unit);
+        glBindTexture(target, id);
+    }
+
+    void Viewport(int x, int y, int width, int height) {
+        if (viewport[0] == x && viewport[1] == y && viewport[2] == width && viewport[3] == height) {
+            stats.skipped++;
+            return;
+        }
+        viewport[0] = x; viewport[1] = y; viewport[2] = width; viewport[3] = height;
+        stats.issued++;
+        glViewport(x, y, width, height);
+    }
+
+    void SetBlend(bool enabled) { setCapability(GL_BLEND, blend, enabled); }
+    void SetDepthTest(bool enabled) { setCapability(GL_DEPTH_TEST, depthTest, enabled); }
+    void SetCullFace(bool enabled) { setCapability(GL_CULL_FACE, cullFace, enabled); }
+
+    void BlendFunc(GLenum src, GLenum dst) {
+        if (blendSrc == src && blendDst == dst) {
+            stats.skipped++;
+            return;
+        }
+        blendSrc = src;
+        blendDst = dst;
+        stats.issued++;
+        glBlendFunc(src, dst);
+    }
+
+    void DepthFunc(GLenum func) {
+        if (!changed(depthFunc, func)) return;
+        glDepthFunc(func);
+    }
+
+    // Also gates glClear of the depth buffer
+    void DepthMask(bool write) {
+        if (depthMask == (int)write) {
+            stats.skipped++;
+            return;
+        }
+        depthMask = (int)write;
+        stats.issued++;
+        glDepthMask(write ? GL_TRUE : GL_FALSE);
+    }
+
+    void CullFace(GLenum mode) {
+        if (!changed(cullMode, mode)) return;
+        glCullFace(mode);
+    }
+
+    // Deleting a bound object silently rebinds 0 and frees the name for reuse, so the cache
+    // has to hear about it
+    void DeleteTexture(GLuint id) {
+        for (int unit = 0; unit < MAX_TEXTURE_UNITS; unit++) {
+            for (int target = 0; target < TEXTURE_TARGETS; target++) {
+                if (textures[unit][target] == id) textures[unit][target] = 0;
+            }
+        }
+        glDeleteTextures(1, &id);
+    }
+
+    void DeleteVertexArray(GLuint id) {
+        if (vertexArray == id) vertexArray = 0;
+        glDeleteVertexArrays(1, &id);
+    }
+
+    void DeleteFramebuffer(GLuint id) {
+        if (framebuffer == id) framebuffer = 0;
+        glDeleteFramebuffers(1, &id);
+    }
+
+private:
+    static const GLuint UNKNOWN = 0xFFFFFFFFu;
+    static const int TEXTURE_TARGETS = 3;
+
+    GLuint program;
+    GLuint vertexArray;
+    GLuint framebuffer;
+    GLuint activeUnit;
+    GLuint textures[MAX_TEXTURE_UNITS][TEXTURE_TARGETS];
+    int viewport[4];
+    int blend, depthTest, cullFace, depthMask; // -1 unknown, else 0/1
+    GLenum blendSrc, blendDst, depthFunc, cullMode;
+
+    GLState() { Invalidate(); }
+
+    static int targetIndex(GLenum target) {
+        switch (target) {
+            case GL_TEXTURE_2D: return 0;
+            case GL_TEXTURE_2D_ARRAY: return 1;
+            case GL_TEXTURE_CUBE_MAP: return 2;
+            default: return -1;
+        }
+    }
+
+    // Records the new value and counts the call; false when it was already current
+    bool changed(GLuint& cached, GLuint value) {
+        if (cached == value) {
+            stats.skipped++;
+            return false;
+        }
+        cached = value;
+        stats.issued++;
+        return true;
+    }
+
+    void setActiveUnit(GLuint unit) {
+        if (!changed(activeUnit, unit)) return;
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+
+    void setCapability(GLenum capability, int& cached, bool enabled) {
+        if (cached == (int)enabled) {
+            stats.skipped++;
+            return;
+        }
+        cached = (int)enabled;
+        stats.issued++;
+        if (enabled) glEnable(capability);
+        else glDisable(capability);
+    }
+};
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <GLFW/glfw3.h>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <iostream>
+
+// Keys the player controller reads, packed one bit each
+enum InputKeyBit : uint32_t {
+    INPUT_KEY_FORWARD  = 1u << 0,
+    INPUT_KEY_BACKWARD = 1u << 1,
+    INPUT_KEY_LEFT     = 1u << 2,
+    INPUT_KEY_RIGHT    = 1u << 3,
+    INPUT_KEY_RUN      = 1u << 4,
+    INPUT_PLAYER_ACTIVE = 1u << 31 // player input was processed this frame (off in UI mode)
+};
+
+struct InputState {
+    uint32_t keys = 0;
+
+    bool Has(uint32_t bit) const { return (keys & bit) != 0; }
+
+    static InputState FromWindow(GLFWwindow* window) {
+        InputState state;
+        if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) state.keys |= INPUT_KEY_FORWARD;
+        if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) state.keys |= INPUT_KEY_BACKWARD;
+        if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) state.keys |= INPUT_KEY_LEFT;
+        if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) state.keys |= INPUT_KEY_RIGHT;
+        if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS) state.keys |= INPUT_KEY_RUN;
+        return state;
+    }
+};
+
+// One frame of recorded input. Mouse deltas are the sum of everything delivered since the
+// previous frame; replay applies them before the keys, the same order the live loop sees.
+struct InputFrame {
+    float deltaTime;
+    float mouseX;
+    float mouseY;
+    uint32_t keys;
+};
+
+// Camera and controller state at the start of a recording, restored before replay
+struct InputRecordingStart {
+    float position[3];
+    float yaw;
+    float pitch;
+    float baseHeight;
+    float headBobTimer;
+    uint32_t headBobEnabled;
+};
+
+// .psxinput: magic, version, frame count, InputRecordingStart, then InputFrame[frameCount]
+const uint32_t PSXINPUT_MAGIC = 0x49585350; // "PSXI"
+const uint32_t PSXINPUT_VERSION = 1;
+
+static_assert(sizeof(InputFrame) == 16, "InputFrame layout is part of the file format");
+static_assert(sizeof(InputRecordingStart) == 32, "InputRecordingStart layout is part of the file format");
+
+class InputRecorder {
+public:
+    InputRecordingStart start = {};
+
+    bool IsRecording() const { return recording; }
+    bool IsReplaying() const { return replaying; }
+    size_t FrameCount() const { return frames.size(); }
+    size_t ReplayPosition() const { return replayIndex; }
+
+    void StartRecording(const InputRecordingStart& initialState) {
+        replaying = false;
+        recording = true;
+        start = initialState;
+        frames.clear();
+        pendingMouseX = pendingMouseY = 0.0f;
+    }
+
+    // Stops recording and writes the file; the frames stay in memory for an immediate replay
+    bool StopRecording(const std::string& path) {
+        if (!recording) return false;
+        recording = false;
+
+        FILE* file = fopen(path.c_str(), "wb");
+        if (!file) {
+            std::cout << "Failed to write input recording: " << path << std::endl;
+            return false;
+        }
+
+        uint32_t header[3] = {PSXINPUT_MAGIC, PSXINPUT_VERSION, (uint32_t)frames.size()};
+        bool ok = fwrite(header, sizeof(header), 1, file) == 1;
+        if (ok) ok = fwrite(&start, sizeof(start), 1, file) == 1;
+        if (ok && !frames.empty()) ok = fwrite(frames.data(), sizeof(InputFrame), frames.size(), file) == frames.size();
+        ok = (fclose(file) == 0) && ok;
+
+        std::cout << (ok ? "Input recording saved: " : "Failed to write input recording: ")
+                  << path << " (" << frames.size() << " frames)" << std::endl;
+        return ok;
+    }
+
+    bool StartReplay(const std::string& path) {
+        FILE* file = fopen(path.c_str(), "rb");
+        if (!file) {
+            std::cout << "Failed to open input recording: " << path << std::endl;
+            return false;
+        }
+
+        long fileSize = -1;
+        if (fseek(file, 0, SEEK_END) == 0) fileSize = ftell(file);
+        rewind(file);
+
+        uint32_t header[3] = {};
+        bool ok = fread(header, sizeof(header), 1, file) == 1 &&
+                  header[0] == PSXINPUT_MAGIC && header[1] == PSXINPUT_VERSION;
+        if (ok) ok = fread(&start, sizeof(start), 1, file) == 1;
+
+        // Check the frame count against the file before trusting it with an allocation
+        if (ok) {
+            uint64_t expected = sizeof(header) + sizeof(start) + (uint64_t)header[2] * sizeof(InputFrame);
+            ok = fileSize >= 0 && (uint64_t)fileSize == expected;
+        }
+        if (ok) {
+            frames.resize(header[2]);
+            ok = frames.empty() || fread(frames.data(), sizeof(InputFrame), frames.size(), file) == frames.size();
+        }
+        fclose(file);
+
+        if (!ok) {
+            std::cout << "Invalid input recording: " << path << std::endl;
+            frames.clear();
+            return false;
+        }
+
+        recording = false;
+        replaying = true;
+        replayIndex = 0;
+        std::cout << "Replaying input: " << path << " (" << frames.size() << " frames)" << std::endl;
+        return true;
+    }
+
+    void StopReplay() {
+        replaying = false;
+    }
+
+    // Live mouse movement while recording; summed into the next recorded frame
+    void AddMouseDelta(float x, float y) {
+        pendingMouseX += x;
+        pendingMouseY += y;
+    }
+
+    void RecordFrame(float deltaTime, const InputState& input) {
+        if (!recording) return;
+        InputFrame frame;
+        frame.deltaTime = deltaTime;
+        frame.mouseX = pendingMouseX;
+        frame.mouseY = pendingMouseY;
+        frame.keys = input.keys;
+        frames.push_back(frame);
+        pendingMouseX = pendingMouseY = 0.0f;
+    }
+
+    // Next recorded frame, or false once the recording is exhausted (replay then stops)
+    bool NextReplayFrame(InputFrame& frame) {
+        if (!replaying) return false;
+        if (replayIndex >= frames.size()) {
+            replaying = false;
+            std::cout << "Input replay finished" << std::endl;
+            return false;
+        }
+        frame = frames[replayIndex++];
+        return true;
+    }
+
+private:
+    std::vector<InputFrame> frames;
+    size_t replayIndex = 0;
+    bool recording = false;
+    bool replaying = false;
+    float pendingMouseX = 0.0f;
+    float pendingMouseY = 0.0f;
+};
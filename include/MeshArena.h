@@ -0,0 +1,276 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <cstddef>
+#include <map>
+#include <iterator>
+#include <iostream>
+#include "GLState.h"
+#include "VertexFormat.h"
+
+// First-fit free list over [0, capacity) in elements. Freed ranges merge with their neighbours
+// so the arena does not fragment into slivers as models come and go.
+class RangeAllocator {
+public:
+    static const uint32_t INVALID = 0xFFFFFFFFu;
+
+    uint32_t capacity = 0;
+    uint32_t used = 0;
+
+    // Offset of count free elements, or INVALID when no free range is large enough
+    uint32_t Allocate(uint32_t count) {
+        if (count == 0) return INVALID;
+        for (auto it = freeRanges.begin(); it != freeRanges.end(); ++it) {
+            if (it->second < count) continue;
+            uint32_t offset = it->first;
+            uint32_t remaining = it->second - count;
+            freeRanges.erase(it);
+            if (remaining > 0) freeRanges[offset + count] = remaining;
+            used += count;
+            return offset;
+        }
+        return INVALID;
+    }
+
+    void Free(uint32_t offset, uint32_t count) {
+        if (count == 0) return;
+        used -= count;
+        insert(offset, count);
+    }
+
+    // The range [capacity, newCapacity) becomes free
+    void Grow(uint32_t newCapacity) {
+        if (newCapacity <= capacity) return;
+        insert(capacity, newCapacity - capacity);
+        capacity = newCapacity;
+    }
+
+private:
+    std::map<uint32_t, uint32_t> freeRanges; // offset -> count
+
+    void insert(uint32_t offset, uint32_t count) {
+        auto next = freeRanges.lower_bound(offset);
+        if (next != freeRanges.begin()) {
+            auto previous = std::prev(next);
+            if (previous->first + previous->second == offset) {
+                offset = previous->first;
+                count += previous->second;
+                freeRanges.erase(previous);
+            }
+        }
+        if (next != freeRanges.end() && offset + count == next->first) {
+            count += next->second;
+            freeRanges.erase(next);
+        }
+        freeRanges[offset] = count;
+    }
+};
+
+// A mesh's slice of the arena. Indices are relative to firstVertex, which is passed to GL as
+// the base vertex, so they never need rewriting when the mesh lands somewhere else. Index
+// space is handed out in 4-byte blocks so 16-bit and 32-bit meshes can share one buffer.
+struct MeshAllocation {
+    uint32_t firstVertex = RangeAllocator::INVALID;
+    uint32_t vertexCount = 0;
+    uint32_t firstIndexBlock = RangeAllocator::INVALID;
+    uint32_t indexBlockCount = 0;
+    uint32_t indexCount = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
+
+    bool IsValid() const { return indexCount > 0; }
+};
+
+// Every model's vertices and indices live in one vertex buffer and one index buffer behind a
+// single VAO, so switching meshes is only a change of offsets. Buffers grow by doubling
+// (copied on the GPU); allocations keep their offsets across a grow.
+class MeshArena {
+public:
+    static const uint32_t INITIAL_VERTICES = 64 * 1024;
+    static const uint32_t INITIAL_INDEX_BLOCKS = 192 * 1024; // 4 bytes each
+
+    // Per-instance data: model matrix (locations 3-6) then a material vec4 (location 8)
+    static const int INSTANCE_FLOATS = 20;
+
+    static MeshArena& Instance() {
+        static MeshArena instance;
+        return instance;
+    }
+
+    // Copy a mesh into the arena; indexSize is 2 or 4. Main thread only
+    MeshAllocation Allocate(const void* vertexData, uint32_t vertexCount, const void* indexData, uint32_t indexCount, uint32_t indexSize) {
+        MeshAllocation allocation;
+        if (vertexCount == 0 || indexCount == 0) return allocation;
+        if (!VAO) create();
+
+        allocation.firstVertex = vertices.Allocate(vertexCount);
+        if (allocation.firstVertex == RangeAllocator::INVALID) {
+            growVertices(vertexCount);
+            allocation.firstVertex = vertices.Allocate(vertexCount);
+        }
+        uint32_t indexBytes = indexCount * indexSize;
+        uint32_t blockCount = (indexBytes + 3) / 4;
+        allocation.firstIndexBlock = indices.Allocate(blockCount);
+        if (allocation.firstIndexBlock == RangeAllocator::INVALID) {
+            growIndices(blockCount);
+            allocation.firstIndexBlock = indices.Allocate(blockCount);
+        }
+        allocation.vertexCount = vertexCount;
+        allocation.indexBlockCount = blockCount;
+        allocation.indexCount = indexCount;
+        allocation.indexType = indexSize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)allocation.firstVertex * sizeof(PackedVertex),
+                        (GLsizeiptr)vertexCount * sizeof(PackedVertex), vertexData);
+
+        // The element binding is VAO state, so upload through the arena's VAO
+        GLState::Instance().BindVertexArray(VAO);
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, indexOffset(allocation), (GLsizeiptr)indexBytes, indexData);
+        return allocation;
+    }
+
+    // CPU bookkeeping only, so it is safe after the context is gone
+    void Free(MeshAllocation& allocation) {
+        if (!allocation.IsValid()) return;
+        vertices.Free(allocation.firstVertex, allocation.vertexCount);
+        indices.Free(allocation.firstIndexBlock, allocation.indexBlockCount);
+        allocation = MeshAllocation();
+    }
+
+    // Point the per-instance attributes at byteOffset inside a buffer of INSTANCE_FLOATS records
+    void SetInstanceBuffer(unsigned int buffer, size_t byteOffset) {
+        GLState::Instance().BindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        const GLsizei stride = INSTANCE_FLOATS * sizeof(float);
+        for (int i = 0; i < 4; i++) {
+            glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE, stride, (void*)(byteOffset + i * 4 * sizeof(float)));
+        }
+        glVertexAttribPointer(8, 4, GL_FLOAT, GL_FALSE, stride, (void*)(byteOffset + 16 * sizeof(float)));
+    }
+
+    // Draws indexCount indices starting firstIndex indices into the mesh's range
+    void Draw(const MeshAllocation& mesh, uint32_t firstIndex, uint32_t indexCount) {
+        GLState::Instance().BindVertexArray(VAO);
+        glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)indexCount, mesh.indexType,
+                                 (const void*)indexOffset(mesh, firstIndex), (GLint)mesh.firstVertex);
+    }
+
+    void DrawInstanced(const MeshAllocation& mesh, uint32_t firstIndex, uint32_t indexCount, int instanceCount) {
+        GLState::Instance().BindVertexArray(VAO);
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, (GLsizei)indexCount, mesh.indexType,
+                                          (const void*)indexOffset(mesh, firstIndex), instanceCount, (GLint)mesh.firstVertex);
+    }
+
+    // Delete the VAO and buffers while the context is still current. Every model must have
+    // released its mesh first: the arena is a function-local static, so leaving this to static
+    // destruction would run after the GL context and global owners are gone
+    void Shutdown() {
+        if (vertices.used != 0 || indices.used != 0) {
+            std::cout << "MeshArena shut down with " << vertices.used << " vertices still allocated" << std::endl;
+        }
+        if (VAO) GLState::Instance().DeleteVertexArray(VAO);
+        if (VBO) glDeleteBuffers(1, &VBO);
+        if (EBO) glDeleteBuffers(1, &EBO);
+        VAO = VBO = EBO = 0;
+        vertices = RangeAllocator();
+        indices = RangeAllocator();
+    }
+
+    uint32_t VerticesUsed() const { return vertices.used; }
+    uint32_t VertexCapacity() const { return vertices.capacity; }
+    size_t IndexBytesUsed() const { return (size_t)indices.used * 4; }
+    size_t IndexBytesCapacity() const { return (size_t)indices.capacity * 4; }
+
+private:
+    unsigned int VAO = 0;
+    unsigned int VBO = 0;
+    unsigned int EBO = 0;
+    RangeAllocator vertices;
+    RangeAllocator indices; // in 4-byte blocks
+
+    MeshArena() {}
+
+    static GLintptr indexOffset(const MeshAllocation& mesh, uint32_t firstIndex = 0) {
+        GLintptr indexSize = mesh.indexType == GL_UNSIGNED_SHORT ? 2 : 4;
+        return (GLintptr)mesh.firstIndexBlock * 4 + (GLintptr)firstIndex * indexSize;
+    }
+
+    void create() {
+        glGenVertexArrays(1, &VAO);
+        VBO = createBuffer(GL_ARRAY_BUFFER, (size_t)INITIAL_VERTICES * sizeof(PackedVertex));
+        vertices.Grow(INITIAL_VERTICES);
+
+        GLState::Instance().BindVertexArray(VAO);
+        EBO = createBuffer(GL_ELEMENT_ARRAY_BUFFER, (size_t)INITIAL_INDEX_BLOCKS * 4);
+        indices.Grow(INITIAL_INDEX_BLOCKS);
+
+        setVertexAttributes();
+        for (int i = 0; i < 4; i++) {
+            glEnableVertexAttribArray(3 + i);
+            glVertexAttribDivisor(3 + i, 1);
+        }
+        glEnableVertexAttribArray(8);
+        glVertexAttribDivisor(8, 1);
+    }
+
+    static unsigned int createBuffer(GLenum target, size_t bytes) {
+        unsigned int buffer;
+        glGenBuffers(1, &buffer);
+        glBindBuffer(target, buffer);
+        glBufferData(target, bytes, NULL, GL_STATIC_DRAW);
+        return buffer;
+    }
+
+    // Attribute pointers capture the bound GL_ARRAY_BUFFER, so this reruns after the VBO is replaced
+    void setVertexAttributes() {
+        GLState::Instance().BindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+
+        // Integer attributes arrive as unnormalized floats; PACKED_VERTEX_GLSL does the decode
+        glVertexAttribPointer(0, 3, GL_SHORT, GL_FALSE, sizeof(PackedVertex), (void*)0);
+        glEnableVertexAttribArray(0);
+
+        glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, Color));
+        glEnableVertexAttribArray(1);
+
+        glVertexAttribPointer(2, 2, GL_SHORT, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, TexCoords));
+        glEnableVertexAttribArray(2);
+
+        glVertexAttribPointer(7, 2, GL_SHORT, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, Normal));
+        glEnableVertexAttribArray(7);
+    }
+
+    static uint32_t grownCapacity(uint32_t capacity, uint32_t needed) {
+        uint32_t grown = capacity * 2;
+        while (grown - capacity < needed) grown *= 2;
+        return grown;
+    }
+
+    // Copy the old contents into a larger buffer; returns the new buffer
+    static unsigned int growBuffer(unsigned int old, size_t oldBytes, size_t newBytes) {
+        unsigned int buffer;
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, newBytes, NULL, GL_STATIC_DRAW);
+        glBindBuffer(GL_COPY_READ_BUFFER, old);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldBytes);
+        glDeleteBuffers(1, &old);
+        return buffer;
+    }
+
+    void growVertices(uint32_t needed) {
+        uint32_t capacity = grownCapacity(vertices.capacity, needed);
+        VBO = growBuffer(VBO, (size_t)vertices.capacity * sizeof(PackedVertex), (size_t)capacity * sizeof(PackedVertex));
+        vertices.Grow(capacity);
+        setVertexAttributes();
+    }
+
+    void growIndices(uint32_t needed) {
+        uint32_t capacity = grownCapacity(indices.capacity, needed);
+        EBO = growBuffer(EBO, (size_t)indices.capacity * 4, (size_t)capacity * 4);
+        indices.Grow(capacity);
+        GLState::Instance().BindVertexArray(VAO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    }
+};
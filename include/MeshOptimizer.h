@@ -0,0 +1,236 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <unordered_map>
+#include "CookedMesh.h"
+#include "VertexFormat.h"
+
+// Import-time index and vertex reordering. Everything here runs once per import on the CPU
+// and is baked into the .psxmesh, so the runtime only ever sees the optimized order.
+
+// Average cache miss ratio: vertex shader runs per triangle through a FIFO post-transform
+// cache of cacheSize entries. 3.0 is the worst case, about 0.5-0.7 is good for a real mesh.
+inline float ComputeACMR(const unsigned int* indices, size_t indexCount, int cacheSize = 16) {
+    if (indexCount < 3) return 0.0f;
+
+    std::vector<unsigned int> cache(cacheSize, 0xFFFFFFFFu);
+    int head = 0;
+    size_t misses = 0;
+    for (size_t i = 0; i < indexCount; i++) {
+        bool hit = false;
+        for (int slot = 0; slot < cacheSize; slot++) {
+            if (cache[slot] == indices[i]) {
+                hit = true;
+                break;
+            }
+        }
+        if (!hit) {
+            cache[head] = indices[i];
+            head = (head + 1) % cacheSize;
+            misses++;
+        }
+    }
+    return (float)misses / (float)(indexCount / 3);
+}
+
+// Merge bit-identical vertices into welded. Returns the remap from each input vertex to its
+// survivor in welded.
+inline std::vector<unsigned int> WeldVertices(const Vertex* vertices, size_t vertexCount,
+                                              std::vector<Vertex>& welded) {
+    struct VertexHash {
+        size_t operator()(const Vertex& v) const {
+            const unsigned char* bytes = (const unsigned char*)&v;
+            uint64_t h = 14695981039346656037ull;
+            for (size_t i = 0; i < sizeof(Vertex); i++) {
+                h ^= bytes[i];
+                h *= 1099511628211ull;
+            }
+            return (size_t)h;
+        }
+    };
+    struct VertexEqual {
+        bool operator()(const Vertex& a, const Vertex& b) const {
+            return memcmp(&a, &b, sizeof(Vertex)) == 0;
+        }
+    };
+
+    std::unordered_map<Vertex, unsigned int, VertexHash, VertexEqual> unique;
+    unique.reserve(vertexCount);
+    std::vector<unsigned int> remap(vertexCount);
+    welded.clear();
+    for (size_t i = 0; i < vertexCount; i++) {
+        auto inserted = unique.emplace(vertices[i], (unsigned int)welded.size());
+        if (inserted.second) welded.push_back(vertices[i]);
+        remap[i] = inserted.first->second;
+    }
+    return remap;
+}
+
+// Tom Forsyth's linear-speed vertex cache optimisation: greedily emit the triangle whose
+// vertices score highest, where the score favours vertices recently used (still in the
+// simulated LRU cache) and vertices with few triangles left (so they are finished off).
+// indices are local to a mesh of vertexCount vertices; rewritten in place.
+inline void OptimizeVertexCache(unsigned int* indices, size_t indexCount, size_t vertexCount) {
+    const int CACHE_SIZE = 32;
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount < 2) return;
+
+    auto vertexScore = [](int cachePosition, int remaining) {
+        if (remaining == 0) return -1.0f;
+        float score = 0.0f;
+        if (cachePosition >= 0) {
+            if (cachePosition < 3) {
+                score = 0.75f; // just used by the previous triangle
+            } else {
+                float scaler = 1.0f / (CACHE_SIZE - 3);
+                score = powf(1.0f - (cachePosition - 3) * scaler, 1.5f);
+            }
+        }
+        return score + 2.0f / sqrtf((float)remaining);
+    };
+
+    // Triangles touching each vertex, as offsets into one flat array
+    std::vector<unsigned int> adjacencyStart(vertexCount + 1, 0);
+    for (size_t i = 0; i < indexCount; i++) adjacencyStart[indices[i] + 1]++;
+    for (size_t v = 0; v < vertexCount; v++) adjacencyStart[v + 1] += adjacencyStart[v];
+    std::vector<unsigned int> adjacency(indexCount);
+    std::vector<unsigned int> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+    for (size_t i = 0; i < indexCount; i++) adjacency[fill[indices[i]]++] = (unsigned int)(i / 3);
+
+    std::vector<int> remaining(vertexCount);
+    std::vector<float> score(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++) {
+        remaining[v] = (int)(adjacencyStart[v + 1] - adjacencyStart[v]);
+        score[v] = vertexScore(-1, remaining[v]);
+    }
+
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    for (size_t t = 0; t < triangleCount; t++) {
+        triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+    }
+
+    std::vector<unsigned int> output;
+    output.reserve(indexCount);
+    std::vector<unsigned int> cache, nextCache;
+    cache.reserve(CACHE_SIZE + 3);
+    nextCache.reserve(CACHE_SIZE + 3);
+    size_t scanCursor = 0;
+
+    while (output.size() < indexCount) {
+        // Best triangle among those touching the cache; when the cache holds nothing useful
+        // (start, or a disconnected piece) take the next triangle not yet emitted
+        long best = -1;
+        float bestScore = -1.0f;
+        for (unsigned int v : cache) {
+            for (unsigned int a = adjacencyStart[v]; a < adjacencyStart[v + 1]; a++) {
+                unsigned int t = adjacency[a];
+                if (!emitted[t] && triangleScore[t] > bestScore) {
+                    bestScore = triangleScore[t];
+                    best = (long)t;
+                }
+            }
+        }
+        if (best < 0) {
+            while (emitted[scanCursor]) scanCursor++;
+            best = (long)scanCursor;
+        }
+
+        const unsigned int* triangle = indices + best * 3;
+        emitted[best] = true;
+        for (int corner = 0; corner < 3; corner++) {
+            output.push_back(triangle[corner]);
+            remaining[triangle[corner]]--;
+        }
+
+        // Emitted vertices move to the front of the LRU cache; the rest shift back
+        nextCache.assign(triangle, triangle + 3);
+        for (unsigned int v : cache) {
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2]) nextCache.push_back(v);
+        }
+        if (nextCache.size() > (size_t)CACHE_SIZE) {
+            // Evicted vertices lose their cache bonus, and so do their triangles
+            for (size_t i = CACHE_SIZE; i < nextCache.size(); i++) {
+                unsigned int v = nextCache[i];
+                score[v] = vertexScore(-1, remaining[v]);
+                for (unsigned int a = adjacencyStart[v]; a < adjacencyStart[v + 1]; a++) {
+                    unsigned int t = adjacency[a];
+                    if (!emitted[t]) {
+                        triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+                    }
+                }
+            }
+            nextCache.resize(CACHE_SIZE);
+        }
+        cache.swap(nextCache);
+
+        for (size_t i = 0; i < cache.size(); i++) {
+            score[cache[i]] = vertexScore((int)i, remaining[cache[i]]);
+        }
+        for (unsigned int v : cache) {
+            for (unsigned int a = adjacencyStart[v]; a < adjacencyStart[v + 1]; a++) {
+                unsigned int t = adjacency[a];
+                if (!emitted[t]) {
+                    triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+                }
+            }
+        }
+    }
+
+    memcpy(indices, output.data(), indexCount * sizeof(unsigned int));
+}
+
+// Renumber vertices in the order the index stream first touches them so fetches walk the
+// vertex buffer forwards. Unreferenced vertices are dropped; returns the new vertex count.
+inline size_t OptimizeVertexFetch(Vertex* vertices, size_t vertexCount, unsigned int* indices, size_t indexCount) {
+    std::vector<unsigned int> remap(vertexCount, 0xFFFFFFFFu);
+    std::vector<Vertex> reordered;
+    reordered.reserve(vertexCount);
+    for (size_t i = 0; i < indexCount; i++) {
+        unsigned int& target = remap[indices[i]];
+        if (target == 0xFFFFFFFFu) {
+            target = (unsigned int)reordered.size();
+            reordered.push_back(vertices[indices[i]]);
+        }
+        indices[i] = target;
+    }
+    memcpy(vertices, reordered.data(), reordered.size() * sizeof(Vertex));
+    return reordered.size();
+}
+
+// Weld, cache-order and fetch-order every submesh of an imported model in place. Submeshes
+// keep their own contiguous vertex and index ranges; indices stay relative to the model's
+// first vertex like the importer produced them.
+inline void OptimizeModelMesh(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices,
+                              std::vector<PsxMeshSubmesh>& submeshes) {
+    std::vector<Vertex> outVertices;
+    std::vector<unsigned int> outIndices;
+    outVertices.reserve(vertices.size());
+    outIndices.reserve(indices.size());
+
+    std::vector<Vertex> welded;
+    std::vector<unsigned int> local;
+    for (PsxMeshSubmesh& submesh : submeshes) {
+        std::vector<unsigned int> remap = WeldVertices(vertices.data() + submesh.firstVertex, submesh.vertexCount, welded);
+
+        local.resize(submesh.indexCount);
+        for (uint32_t i = 0; i < submesh.indexCount; i++) {
+            local[i] = remap[indices[submesh.firstIndex + i] - submesh.firstVertex];
+        }
+
+        OptimizeVertexCache(local.data(), local.size(), welded.size());
+        size_t used = OptimizeVertexFetch(welded.data(), welded.size(), local.data(), local.size());
+
+        submesh.firstVertex = (uint32_t)outVertices.size();
+        submesh.vertexCount = (uint32_t)used;
+        submesh.firstIndex = (uint32_t)outIndices.size();
+        outVertices.insert(outVertices.end(), welded.begin(), welded.begin() + used);
+        for (unsigned int index : local) outIndices.push_back(submesh.firstVertex + index);
+    }
+
+    vertices.swap(outVertices);
+    indices.swap(outIndices);
+}
@@ -0,0 +1,260 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <queue>
+#include <unordered_map>
+#include "CookedMesh.h"
+#include "VertexFormat.h"
+#include "MeshOptimizer.h"
+#include "PsxMath.h"
+
+// Import-time LOD generation by quadric edge collapse (Garland & Heckbert). Collapses are
+// half-edge: a vertex merges into a neighbour that already exists, so the simplified levels
+// index the same vertex buffer as LOD 0 and need no new vertices.
+
+// Symmetric 4x4 error quadric, upper triangle: a00 a01 a02 a03 a11 a12 a13 a22 a23 a33
+struct Quadric {
+    double q[10] = {};
+
+    void AddPlane(double a, double b, double c, double d, double weight) {
+        q[0] += weight * a * a; q[1] += weight * a * b; q[2] += weight * a * c; q[3] += weight * a * d;
+        q[4] += weight * b * b; q[5] += weight * b * c; q[6] += weight * b * d;
+        q[7] += weight * c * c; q[8] += weight * c * d;
+        q[9] += weight * d * d;
+    }
+
+    void Add(const Quadric& other) {
+        for (int i = 0; i < 10; i++) q[i] += other.q[i];
+    }
+
+    double Error(const float* p) const {
+        double x = p[0], y = p[1], z = p[2];
+        return q[0] * x * x + 2.0 * q[1] * x * y + 2.0 * q[2] * x * z + 2.0 * q[3] * x +
+               q[4] * y * y + 2.0 * q[5] * y * z + 2.0 * q[6] * y +
+               q[7] * z * z + 2.0 * q[8] * z + q[9];
+    }
+};
+
+// Simplify one mesh (indices local to vertices) towards targetIndexCount and write the
+// surviving triangles to out. Vertices on open borders and on attribute seams (a position
+// shared by vertices with different UVs, normals or colours) are never moved, which keeps
+// silhouettes and UV seams intact. Returns the output index count; it stays above the target
+// when only locked vertices are left to collapse.
+inline size_t SimplifyMesh(const Vertex* vertices, size_t vertexCount, const unsigned int* indices,
+                           size_t indexCount, size_t targetIndexCount, std::vector<unsigned int>& out) {
+    size_t triangleCount = indexCount / 3;
+    std::vector<unsigned int> triangles(indices, indices + triangleCount * 3);
+
+    // Vertices sharing a position form one group; a group of more than one is a seam
+    std::vector<unsigned int> group(vertexCount);
+    std::vector<unsigned int> groupSize;
+    {
+        struct Position {
+            uint32_t bits[3];
+            bool operator==(const Position& other) const { return memcmp(bits, other.bits, sizeof(bits)) == 0; }
+        };
+        struct PositionHash {
+            size_t operator()(const Position& p) const {
+                return (size_t)(p.bits[0] * 73856093u ^ p.bits[1] * 19349663u ^ p.bits[2] * 83492791u);
+            }
+        };
+        std::unordered_map<Position, unsigned int, PositionHash> groups;
+        groups.reserve(vertexCount);
+        for (size_t v = 0; v < vertexCount; v++) {
+            Position key;
+            memcpy(key.bits, vertices[v].Position, sizeof(key.bits));
+            auto inserted = groups.emplace(key, (unsigned int)groupSize.size());
+            if (inserted.second) groupSize.push_back(0);
+            group[v] = inserted.first->second;
+            groupSize[group[v]]++;
+        }
+    }
+
+    std::vector<bool> locked(vertexCount, false);
+    for (size_t v = 0; v < vertexCount; v++) {
+        if (groupSize[group[v]] > 1) locked[v] = true;
+    }
+
+    // An edge between position groups used by exactly one triangle is an open border
+    std::unordered_map<uint64_t, int> edgeUse;
+    for (size_t t = 0; t < triangleCount; t++) {
+        for (int corner = 0; corner < 3; corner++) {
+            uint32_t a = group[triangles[t * 3 + corner]];
+            uint32_t b = group[triangles[t * 3 + (corner + 1) % 3]];
+            uint64_t key = a < b ? ((uint64_t)a << 32 | b) : ((uint64_t)b << 32 | a);
+            edgeUse[key]++;
+        }
+    }
+    std::vector<bool> borderGroup(groupSize.size(), false);
+    for (const auto& edge : edgeUse) {
+        if (edge.second == 1) {
+            borderGroup[edge.first >> 32] = true;
+            borderGroup[edge.first & 0xFFFFFFFFu] = true;
+        }
+    }
+    for (size_t v = 0; v < vertexCount; v++) {
+        if (borderGroup[group[v]]) locked[v] = true;
+    }
+
+    // Plane quadrics, area weighted so slivers do not dominate
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t t = 0; t < triangleCount; t++) {
+        const float* p0 = vertices[triangles[t * 3]].Position;
+        const float* p1 = vertices[triangles[t * 3 + 1]].Position;
+        const float* p2 = vertices[triangles[t * 3 + 2]].Position;
+        double e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+        double e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+        double n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+        double length = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (length <= 0.0) continue;
+        n[0] /= length; n[1] /= length; n[2] /= length;
+        double d = -(n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2]);
+        for (int corner = 0; corner < 3; corner++) {
+            quadrics[triangles[t * 3 + corner]].AddPlane(n[0], n[1], n[2], d, length * 0.5);
+        }
+    }
+
+    std::vector<std::vector<unsigned int>> vertexTriangles(vertexCount);
+    for (size_t t = 0; t < triangleCount; t++) {
+        for (int corner = 0; corner < 3; corner++) vertexTriangles[triangles[t * 3 + corner]].push_back((unsigned int)t);
+    }
+
+    struct Collapse {
+        double cost;
+        unsigned int from, to;
+        unsigned int fromStamp, toStamp;
+        bool operator>(const Collapse& other) const { return cost > other.cost; }
+    };
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> heap;
+    std::vector<unsigned int> stamp(vertexCount, 0);
+    std::vector<bool> removed(vertexCount, false);
+    std::vector<bool> dead(triangleCount, false);
+
+    auto push = [&](unsigned int from, unsigned int to) {
+        if (locked[from] || from == to) return;
+        Quadric combined = quadrics[from];
+        combined.Add(quadrics[to]);
+        heap.push({combined.Error(vertices[to].Position), from, to, stamp[from], stamp[to]});
+    };
+    for (size_t t = 0; t < triangleCount; t++) {
+        for (int corner = 0; corner < 3; corner++) {
+            unsigned int a = triangles[t * 3 + corner];
+            unsigned int b = triangles[t * 3 + (corner + 1) % 3];
+            push(a, b);
+            push(b, a);
+        }
+    }
+
+    // Moving from onto to must not turn any remaining triangle around from inside out
+    auto flips = [&](unsigned int from, unsigned int to) {
+        for (unsigned int t : vertexTriangles[from]) {
+            if (dead[t]) continue;
+            const unsigned int* tri = &triangles[t * 3];
+            if (tri[0] == to || tri[1] == to || tri[2] == to) continue;
+            float before[3], after[3];
+            const float* p[3];
+            for (int corner = 0; corner < 3; corner++) p[corner] = vertices[tri[corner]].Position;
+            float e1[3], e2[3];
+            for (int i = 0; i < 3; i++) { e1[i] = p[1][i] - p[0][i]; e2[i] = p[2][i] - p[0][i]; }
+            Cross3(e1, e2, before);
+            for (int corner = 0; corner < 3; corner++) if (tri[corner] == from) p[corner] = vertices[to].Position;
+            for (int i = 0; i < 3; i++) { e1[i] = p[1][i] - p[0][i]; e2[i] = p[2][i] - p[0][i]; }
+            Cross3(e1, e2, after);
+            if (before[0] * after[0] + before[1] * after[1] + before[2] * after[2] <= 0.0f) return true;
+        }
+        return false;
+    };
+
+    size_t liveIndices = triangleCount * 3;
+    while (liveIndices > targetIndexCount && !heap.empty()) {
+        Collapse collapse = heap.top();
+        heap.pop();
+        unsigned int from = collapse.from, to = collapse.to;
+        if (removed[from] || removed[to]) continue;
+        if (collapse.fromStamp != stamp[from] || collapse.toStamp != stamp[to]) continue;
+        if (flips(from, to)) continue;
+
+        removed[from] = true;
+        for (unsigned int t : vertexTriangles[from]) {
+            if (dead[t]) continue;
+            unsigned int* tri = &triangles[t * 3];
+            if (tri[0] == to || tri[1] == to || tri[2] == to) {
+                dead[t] = true;
+                liveIndices -= 3;
+                continue;
+            }
+            for (int corner = 0; corner < 3; corner++) if (tri[corner] == from) tri[corner] = to;
+            vertexTriangles[to].push_back(t);
+        }
+        quadrics[to].Add(quadrics[from]);
+        stamp[to]++;
+
+        // Drop dead triangles from the survivor's list, then requeue its edges at the new cost
+        std::vector<unsigned int>& around = vertexTriangles[to];
+        size_t kept = 0;
+        for (unsigned int t : around) if (!dead[t]) around[kept++] = t;
+        around.resize(kept);
+        for (unsigned int t : around) {
+            for (int corner = 0; corner < 3; corner++) {
+                unsigned int other = triangles[t * 3 + corner];
+                if (other == to) continue;
+                push(other, to);
+                push(to, other);
+            }
+        }
+    }
+
+    out.clear();
+    for (size_t t = 0; t < triangleCount; t++) {
+        if (!dead[t]) out.insert(out.end(), &triangles[t * 3], &triangles[t * 3 + 3]);
+    }
+    return out.size();
+}
+
+// Append up to maxLods - 1 simplified levels to indices, each about half the triangles of the
+// one before, and fill lods with every level's index range (lods[0] is the full mesh).
+// Stops early when a level would not save at least a fifth of the previous one.
+inline void BuildModelLods(const std::vector<Vertex>& vertices, std::vector<unsigned int>& indices,
+                           const std::vector<PsxMeshSubmesh>& submeshes, std::vector<PsxMeshLod>& lods, int maxLods) {
+    lods.clear();
+    lods.push_back({0, (uint32_t)indices.size()});
+
+    // Current level per submesh, in submesh-local indices
+    std::vector<std::vector<unsigned int>> levels(submeshes.size());
+    for (size_t s = 0; s < submeshes.size(); s++) {
+        const PsxMeshSubmesh& submesh = submeshes[s];
+        levels[s].resize(submesh.indexCount);
+        for (uint32_t i = 0; i < submesh.indexCount; i++) {
+            levels[s][i] = indices[submesh.firstIndex + i] - submesh.firstVertex;
+        }
+    }
+
+    std::vector<unsigned int> simplified;
+    for (int level = 1; level < maxLods; level++) {
+        size_t previousTotal = 0, total = 0;
+        std::vector<std::vector<unsigned int>> next(submeshes.size());
+        for (size_t s = 0; s < submeshes.size(); s++) {
+            const PsxMeshSubmesh& submesh = submeshes[s];
+            size_t target = (levels[s].size() / 6) * 3;
+            SimplifyMesh(vertices.data() + submesh.firstVertex, submesh.vertexCount,
+                         levels[s].data(), levels[s].size(), target, simplified);
+            OptimizeVertexCache(simplified.data(), simplified.size(), submesh.vertexCount);
+            previousTotal += levels[s].size();
+            total += simplified.size();
+            next[s] = simplified;
+        }
+        if (total == 0 || total * 5 > previousTotal * 4) break;
+
+        PsxMeshLod lod;
+        lod.firstIndex = (uint32_t)indices.size();
+        lod.indexCount = (uint32_t)total;
+        for (size_t s = 0; s < submeshes.size(); s++) {
+            for (unsigned int index : next[s]) indices.push_back(submeshes[s].firstVertex + index);
+        }
+        lods.push_back(lod);
+        levels.swap(next);
+    }
+}
@@ -5,21 +5,110 @@
 #include <cstdlib>
 #include <ctime>
 #include "Shader.h"
+#include "Profiler.h"
+#include "GLState.h"
 
-struct Particle {
-    float position[3];
-    float velocity[3];
-    float life;
-    float maxLife;
-    float size;
-    float alpha;
-    
-    bool active = false;
+#if defined(__GNUC__) && defined(__SSE__)
+#include <immintrin.h>
+#define PSX_PARTICLES_SIMD 1
+#define PSX_TARGET_AVX __attribute__((target("avx")))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <immintrin.h>
+#include <intrin.h>
+#define PSX_PARTICLES_SIMD 1
+#define PSX_TARGET_AVX
+#endif
+
+// Live particles stored as parallel arrays; [0, liveCount) is always packed
+struct ParticleArrays {
+    std::vector<float> posX, posY, posZ;
+    std::vector<float> velX, velY, velZ;
+    std::vector<float> life;
+    std::vector<float> invMaxLife;
+    std::vector<float> size;
+    std::vector<float> alpha;
+
+    void resize(size_t count) {
+        for (std::vector<float>* array : {&posX, &posY, &posZ, &velX, &velY, &velZ, &life, &invMaxLife, &size, &alpha}) {
+            array->assign(count, 0.0f);
+        }
+    }
+
+    void copy(size_t from, size_t to) {
+        posX[to] = posX[from]; posY[to] = posY[from]; posZ[to] = posZ[from];
+        velX[to] = velX[from]; velY[to] = velY[from]; velZ[to] = velZ[from];
+        life[to] = life[from];
+        invMaxLife[to] = invMaxLife[from];
+        size[to] = size[from];
+        alpha[to] = alpha[from];
+    }
 };
 
+// Integrate position, age and fade for count particles (count is a multiple of 8)
+typedef void (*ParticleIntegrateFn)(ParticleArrays& p, size_t count, float deltaTime);
+
+inline void IntegrateParticlesScalar(ParticleArrays& p, size_t count, float deltaTime) {
+    for (size_t i = 0; i < count; i++) {
+        p.posX[i] += p.velX[i] * deltaTime;
+        p.posY[i] += p.velY[i] * deltaTime;
+        p.posZ[i] += p.velZ[i] * deltaTime;
+        p.life[i] -= deltaTime;
+        p.alpha[i] = p.life[i] * p.invMaxLife[i];
+    }
+}
+
+#ifdef PSX_PARTICLES_SIMD
+inline void IntegrateParticlesSSE(ParticleArrays& p, size_t count, float deltaTime) {
+    const __m128 dt = _mm_set1_ps(deltaTime);
+    for (size_t i = 0; i < count; i += 4) {
+        _mm_storeu_ps(&p.posX[i], _mm_add_ps(_mm_loadu_ps(&p.posX[i]), _mm_mul_ps(_mm_loadu_ps(&p.velX[i]), dt)));
+        _mm_storeu_ps(&p.posY[i], _mm_add_ps(_mm_loadu_ps(&p.posY[i]), _mm_mul_ps(_mm_loadu_ps(&p.velY[i]), dt)));
+        _mm_storeu_ps(&p.posZ[i], _mm_add_ps(_mm_loadu_ps(&p.posZ[i]), _mm_mul_ps(_mm_loadu_ps(&p.velZ[i]), dt)));
+        __m128 life = _mm_sub_ps(_mm_loadu_ps(&p.life[i]), dt);
+        _mm_storeu_ps(&p.life[i], life);
+        _mm_storeu_ps(&p.alpha[i], _mm_mul_ps(life, _mm_loadu_ps(&p.invMaxLife[i])));
+    }
+}
+
+PSX_TARGET_AVX inline void IntegrateParticlesAVX(ParticleArrays& p, size_t count, float deltaTime) {
+    const __m256 dt = _mm256_set1_ps(deltaTime);
+    for (size_t i = 0; i < count; i += 8) {
+        _mm256_storeu_ps(&p.posX[i], _mm256_add_ps(_mm256_loadu_ps(&p.posX[i]), _mm256_mul_ps(_mm256_loadu_ps(&p.velX[i]), dt)));
+        _mm256_storeu_ps(&p.posY[i], _mm256_add_ps(_mm256_loadu_ps(&p.posY[i]), _mm256_mul_ps(_mm256_loadu_ps(&p.velY[i]), dt)));
+        _mm256_storeu_ps(&p.posZ[i], _mm256_add_ps(_mm256_loadu_ps(&p.posZ[i]), _mm256_mul_ps(_mm256_loadu_ps(&p.velZ[i]), dt)));
+        __m256 life = _mm256_sub_ps(_mm256_loadu_ps(&p.life[i]), dt);
+        _mm256_storeu_ps(&p.life[i], life);
+        _mm256_storeu_ps(&p.alpha[i], _mm256_mul_ps(life, _mm256_loadu_ps(&p.invMaxLife[i])));
+    }
+}
+
+inline bool CpuSupportsAVX() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    return osxsave && avx && (_xgetbv(0) & 0x6) == 0x6;
+#else
+    return __builtin_cpu_supports("avx");
+#endif
+}
+#endif
+
+// Widest kernel this CPU can run, picked once at startup
+inline ParticleIntegrateFn SelectParticleIntegrate() {
+#ifdef PSX_PARTICLES_SIMD
+    return CpuSupportsAVX() ? IntegrateParticlesAVX : IntegrateParticlesSSE;
+#else
+    return IntegrateParticlesScalar;
+#endif
+}
+
 class ParticleSystem {
 public:
-    std::vector<Particle> particles;
+    ParticleArrays particles;
+    int liveCount = 0;
+    int maxParticles;
     unsigned int VAO, VBO;
     Shader* particleShader;
     
@@ -29,8 +118,10 @@ public:
     // Made spawn box smaller and closer to camera
     float spawnBox[6] = {-5.0f, 5.0f, 0.0f, 3.0f, -5.0f, 5.0f};
     
-    ParticleSystem(int maxParticles = 1000) {
-        particles.resize(maxParticles);
+    ParticleSystem(int maxParticles = 1000) : maxParticles(maxParticles) {
+        // Padded to a whole SIMD block so the kernels never need a scalar tail
+        particles.resize((maxParticles + 7) & ~7);
+        integrate = SelectParticleIntegrate();
         srand(time(nullptr));
         setupRenderData();
         createShader();
@@ -50,80 +141,94 @@ public:
             lastSpawn = 0.0f;
         }
         
-        for (auto& particle : particles) {
-            if (!particle.active) continue;
-            
-            particle.position[0] += particle.velocity[0] * deltaTime;
-            particle.position[1] += particle.velocity[1] * deltaTime;
-            particle.position[2] += particle.velocity[2] * deltaTime;
-            
-            particle.life -= deltaTime;
-            particle.alpha = particle.life / particle.maxLife;
-            
-            if (particle.life <= 0.0f) {
-                particle.active = false;
+        integrate(particles, ((size_t)liveCount + 7) & ~(size_t)7, deltaTime);
+        
+        // Swap-remove dead particles so the live range stays packed
+        int i = 0;
+        while (i < liveCount) {
+            if (particles.life[i] <= 0.0f) {
+                liveCount--;
+                particles.copy(liveCount, i);
+            } else {
+                i++;
             }
         }
     }
     
-    void Render(const float* view, const float* projection, const float* cameraPos) {
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        glDepthMask(GL_FALSE);
+    // View, projection and camera position come from the FrameConstants block. Returns
+    // whether a draw was issued
+    bool Render() {
+        ProfileScope scope("Particles");
+        if (liveCount == 0) return false;
         
-        particleShader->use();
-        particleShader->setMat4("view", view);
-        particleShader->setMat4("projection", projection);
-        particleShader->setVec3("cameraPos", cameraPos[0], cameraPos[1], cameraPos[2]);
+        GLState& state = GLState::Instance();
+        state.SetBlend(true);
+        state.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        state.SetDepthTest(true);
+        state.DepthFunc(GL_LESS);
+        state.DepthMask(false);
         
-        glBindVertexArray(VAO);
+        particleShader->use();
         
-        int renderedCount = 0;
-        for (const auto& particle : particles) {
-            if (!particle.active) continue;
-            
-            particleShader->setVec3("particlePos", particle.position[0], particle.position[1], particle.position[2]);
-            particleShader->setFloat("particleSize", particle.size);
-            particleShader->setFloat("particleAlpha", particle.alpha);
-            
-            glDrawArrays(GL_TRIANGLES, 0, 6);
-            renderedCount++;
-        }
+        state.BindVertexArray(VAO);
+        if (!uploadInstances()) return false; // the orphaned buffer holds nothing this frame
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 6, liveCount);
+        return true;
+    }
+    
+    ~ParticleSystem() {
+        GLState::Instance().DeleteVertexArray(VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &instanceVBO);
+        delete particleShader;
+    }
+    
+private:
+    // Per instance: x, y, z, size, alpha
+    static const int INSTANCE_FLOATS = 5;
+    
+    unsigned int instanceVBO;
+    ParticleIntegrateFn integrate;
+    
+    // Orphan the buffer and write the live range straight into the new storage, interleaving the
+    // SoA arrays. False when the buffer could not be mapped or its contents were lost on unmap
+    bool uploadInstances() {
+        size_t bytes = (size_t)maxParticles * INSTANCE_FLOATS * sizeof(float);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, bytes, NULL, GL_STREAM_DRAW);
         
-        glDepthMask(GL_TRUE);
-        glDisable(GL_BLEND);
+        float* out = (float*)glMapBufferRange(GL_ARRAY_BUFFER, 0, (size_t)liveCount * INSTANCE_FLOATS * sizeof(float),
+                                              GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (!out) return false;
         
-        // Debug output (remove this later)
-        static float debugTimer = 0.0f;
-        debugTimer += 0.016f; // assume 60fps
-        if (debugTimer > 2.0f) {
-            std::cout << "Rendering " << renderedCount << " particles" << std::endl;
-            debugTimer = 0.0f;
+        for (int i = 0; i < liveCount; i++) {
+            out[0] = particles.posX[i];
+            out[1] = particles.posY[i];
+            out[2] = particles.posZ[i];
+            out[3] = particles.size[i];
+            out[4] = particles.alpha[i];
+            out += INSTANCE_FLOATS;
         }
+        return glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE;
     }
     
-private:
     void SpawnParticle(const float* cameraPos) {
-        for (auto& particle : particles) {
-            if (particle.active) continue;
-            
-            // Spawn closer to camera and at visible heights
-            particle.position[0] = cameraPos[0] + RandomFloat(spawnBox[0], spawnBox[1]);
-            particle.position[1] = cameraPos[1] + RandomFloat(spawnBox[2], spawnBox[3]);
-            particle.position[2] = cameraPos[2] + RandomFloat(spawnBox[4], spawnBox[5]);
-            
-            particle.velocity[0] = RandomFloat(-0.5f, 0.5f);
-            particle.velocity[1] = RandomFloat(-0.2f, 0.2f);
-            particle.velocity[2] = RandomFloat(-0.5f, 0.5f);
-            
-            particle.life = RandomFloat(5.0f, 10.0f);
-            particle.maxLife = particle.life;
-            particle.size = RandomFloat(0.02f, 0.08f); // Tiny dust particles
-            particle.alpha = 1.0f;
-            particle.active = true;
-            
-            break;
-        }
+        if (liveCount >= maxParticles) return;
+        int i = liveCount++;
+        
+        // Spawn closer to camera and at visible heights
+        particles.posX[i] = cameraPos[0] + RandomFloat(spawnBox[0], spawnBox[1]);
+        particles.posY[i] = cameraPos[1] + RandomFloat(spawnBox[2], spawnBox[3]);
+        particles.posZ[i] = cameraPos[2] + RandomFloat(spawnBox[4], spawnBox[5]);
+        
+        particles.velX[i] = RandomFloat(-0.5f, 0.5f);
+        particles.velY[i] = RandomFloat(-0.2f, 0.2f);
+        particles.velZ[i] = RandomFloat(-0.5f, 0.5f);
+        
+        particles.life[i] = RandomFloat(5.0f, 10.0f);
+        particles.invMaxLife[i] = 1.0f / particles.life[i];
+        particles.size[i] = RandomFloat(0.02f, 0.08f); // Tiny dust particles
+        particles.alpha[i] = 1.0f;
     }
     
     float RandomFloat(float min, float max) {
@@ -143,32 +248,43 @@ private:
         
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
+        glGenBuffers(1, &instanceVBO);
         
-        glBindVertexArray(VAO);
+        GLState::Instance().BindVertexArray(VAO);
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
         
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
         glEnableVertexAttribArray(0);
         
-        glBindVertexArray(0);
+        // Instance stream: vec4 (position, size) at location 1, alpha at location 2
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, (size_t)maxParticles * INSTANCE_FLOATS * sizeof(float), NULL, GL_STREAM_DRAW);
+        
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, INSTANCE_FLOATS * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribDivisor(1, 1);
+        
+        glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, INSTANCE_FLOATS * sizeof(float), (void*)(4 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+        glVertexAttribDivisor(2, 1);
     }
     
     void createShader() {
-        std::string vertexSource = R"(
-            #version 330 core
+        std::string vertexSource = std::string(R"(
+            #version 330 core)") + FRAME_CONSTANTS_GLSL + R"(
             layout (location = 0) in vec3 aPos;
-            
-            uniform mat4 view;
-            uniform mat4 projection;
-            uniform vec3 particlePos;
-            uniform float particleSize;
-            uniform vec3 cameraPos;
+            layout (location = 1) in vec4 aPosSize;
+            layout (location = 2) in float aAlpha;
             
             out vec2 TexCoord;
-            out vec3 worldPos;
+            out float particleAlpha;
             
             void main() {
+                vec3 particlePos = aPosSize.xyz;
+                float particleSize = aPosSize.w;
+                particleAlpha = aAlpha;
+                
                 // Billboard the particle to always face camera
                 vec3 cameraRight = vec3(view[0][0], view[1][0], view[2][0]);
                 vec3 cameraUp = vec3(view[0][1], view[1][1], view[2][1]);
@@ -184,10 +300,9 @@ private:
         std::string fragmentSource = R"(
             #version 330 core
             in vec2 TexCoord;
+            in float particleAlpha;
             out vec4 FragColor;
             
-            uniform float particleAlpha;
-            
             void main() {
                 // Create sharp circular particle - no blurriness
                 vec2 center = vec2(0.5, 0.5);
@@ -3,6 +3,7 @@
 #include <GLFW/glfw3.h>
 #include <cmath>
 #include "Camera.h"
+#include "InputRecorder.h"
 
 enum class MovementState {
     IDLE,
@@ -46,28 +47,16 @@ public:
     }
     
     void ProcessKeyboardInput(GLFWwindow* window, float deltaTime) {
-        // Reset movement flags
-        movingForward = movingBackward = movingLeft = movingRight = false;
-        isRunning = false;
-        
-        // Check for running (Left Shift)
-        if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS) {
-            isRunning = true;
-        }
-        
-        // Movement input
-        if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
-            movingForward = true;
-        }
-        if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
-            movingBackward = true;
-        }
-        if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
-            movingLeft = true;
-        }
-        if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
-            movingRight = true;
-        }
+        ProcessInput(InputState::FromWindow(window), deltaTime);
+    }
+    
+    // Same as ProcessKeyboardInput but from a captured key state, so recorded input can drive it
+    void ProcessInput(const InputState& input, float deltaTime) {
+        isRunning = input.Has(INPUT_KEY_RUN);
+        movingForward = input.Has(INPUT_KEY_FORWARD);
+        movingBackward = input.Has(INPUT_KEY_BACKWARD);
+        movingLeft = input.Has(INPUT_KEY_LEFT);
+        movingRight = input.Has(INPUT_KEY_RIGHT);
         
         // Update movement state
         UpdateMovementState();
@@ -99,6 +88,32 @@ public:
         playerCamera->updateCameraVectors();
     }
     
+    // Everything the replayed path depends on besides the input itself
+    InputRecordingStart CaptureState() const {
+        InputRecordingStart state = {};
+        if (playerCamera) {
+            for (int i = 0; i < 3; i++) state.position[i] = playerCamera->Position[i];
+            state.yaw = playerCamera->Yaw;
+            state.pitch = playerCamera->Pitch;
+        }
+        state.baseHeight = baseHeight;
+        state.headBobTimer = headBobTimer;
+        state.headBobEnabled = headBobEnabled ? 1 : 0;
+        return state;
+    }
+    
+    void RestoreState(const InputRecordingStart& state) {
+        if (playerCamera) {
+            for (int i = 0; i < 3; i++) playerCamera->Position[i] = state.position[i];
+            playerCamera->Yaw = state.yaw;
+            playerCamera->Pitch = state.pitch;
+            playerCamera->updateCameraVectors();
+        }
+        baseHeight = state.baseHeight;
+        headBobTimer = state.headBobTimer;
+        headBobEnabled = state.headBobEnabled != 0;
+    }
+    
     void SetCamera(Camera* camera) {
         playerCamera = camera;
         if (playerCamera) {
@@ -1,11 +1,13 @@
 #pragma once
 
 #include <glad/glad.h>
-#include <GLFW/glfw3.h>
 #include "Shader.h"
 #include "ShaderManager.h"
+#include "Profiler.h"
+#include "GLState.h"
 #include <vector>
 #include <string>
+#include <algorithm>
 
 enum class EffectType {
     PSX_RETRO,
@@ -84,13 +86,15 @@ public:
     }
     
     void BeginRender() {
-        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
-        glViewport(0, 0, width, height);
+        GLState& state = GLState::Instance();
+        state.BindFramebuffer(framebuffer);
+        state.Viewport(0, 0, width, height);
+        state.DepthMask(true); // glClear honours the depth write mask
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     }
     
     void EndRender() {
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        GLState::Instance().BindFramebuffer(0);
     }
     
     void ToggleAllEffects() {
@@ -102,7 +106,9 @@ public:
     }
     
     void RenderToScreen(int screenWidth, int screenHeight) {
-        glViewport(0, 0, screenWidth, screenHeight);
+        ProfileScope scope("PostProcess");
+        GLState& state = GLState::Instance();
+        state.Viewport(0, 0, screenWidth, screenHeight);
         glClear(GL_COLOR_BUFFER_BIT);
         
         if (!effectsEnabled) {
@@ -122,36 +128,36 @@ public:
             if (!shader) return;
             
             shader->use();
-            setShaderUniforms(shader, screenWidth, screenHeight);
+            setShaderUniforms(shader);
         }
         
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, colorTexture);
-        
-        glBindVertexArray(quadVAO);
-        glDisable(GL_DEPTH_TEST);
+        state.BindTexture(0, GL_TEXTURE_2D, colorTexture);
+        state.BindVertexArray(quadVAO);
+        state.SetBlend(false);
+        state.SetDepthTest(false);
         glDrawArrays(GL_TRIANGLES, 0, 6);
-        glEnable(GL_DEPTH_TEST);
     }
     
     void Resize(int w, int h) {
         width = w;
         height = h;
         
-        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        GLState& state = GLState::Instance();
+        state.BindFramebuffer(framebuffer);
         
-        glBindTexture(GL_TEXTURE_2D, colorTexture);
+        state.BindTexture(0, GL_TEXTURE_2D, colorTexture);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
         
-        glBindTexture(GL_TEXTURE_2D, depthTexture);
+        state.BindTexture(0, GL_TEXTURE_2D, depthTexture);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
     }
     
     ~PostProcessEffect() {
-        glDeleteFramebuffers(1, &framebuffer);
-        glDeleteTextures(1, &colorTexture);
-        glDeleteTextures(1, &depthTexture);
-        glDeleteVertexArrays(1, &quadVAO);
+        GLState& state = GLState::Instance();
+        state.DeleteFramebuffer(framebuffer);
+        state.DeleteTexture(colorTexture);
+        state.DeleteTexture(depthTexture);
+        state.DeleteVertexArray(quadVAO);
         glDeleteBuffers(1, &quadVBO);
     }
 
@@ -206,13 +212,8 @@ private:
         
     }
     
-    void setShaderUniforms(Shader* shader, int screenWidth, int screenHeight) {
-        shader->setFloat("time", glfwGetTime());
-        shader->setFloat("screenWidth", (float)screenWidth);
-        shader->setFloat("screenHeight", (float)screenHeight);
-        shader->setFloat("renderWidth", (float)width);
-        shader->setFloat("renderHeight", (float)height);
-        
+    // Time and the screen and render sizes come from the FrameConstants block
+    void setShaderUniforms(Shader* shader) {
         for (const auto& effect : effects) {
             if (!effect.enabled) continue;
             
@@ -239,18 +240,19 @@ private:
 
 private:
     void setupFramebuffer() {
+        GLState& state = GLState::Instance();
         glGenFramebuffers(1, &framebuffer);
-        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        state.BindFramebuffer(framebuffer);
         
         glGenTextures(1, &colorTexture);
-        glBindTexture(GL_TEXTURE_2D, colorTexture);
+        state.BindTexture(0, GL_TEXTURE_2D, colorTexture);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
         glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
         
         glGenTextures(1, &depthTexture);
-        glBindTexture(GL_TEXTURE_2D, depthTexture);
+        state.BindTexture(0, GL_TEXTURE_2D, depthTexture);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -260,7 +262,7 @@ private:
             std::cout << "Framebuffer not complete!" << std::endl;
         }
         
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        state.BindFramebuffer(0);
     }
     
     void setupQuad() {
@@ -275,7 +277,7 @@ private:
         
         glGenVertexArrays(1, &quadVAO);
         glGenBuffers(1, &quadVBO);
-        glBindVertexArray(quadVAO);
+        GLState::Instance().BindVertexArray(quadVAO);
         glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
         glEnableVertexAttribArray(0);
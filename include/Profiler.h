@@ -0,0 +1,205 @@
+#pragma once
+
+#include <glad/glad.h>
+#include "Trace.h"
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+// Per-pass CPU and GPU timings. CPU scopes use a high resolution clock; GPU scopes record
+// GL_TIMESTAMP queries into a ring of GPU_LATENCY frames and are read back only once the
+// results are available, so the profiler never stalls the pipeline.
+class Profiler {
+public:
+    static const int HISTORY_SIZE = 100;
+    static const int GPU_LATENCY = 4;
+
+    struct Pass {
+        const char* name;
+        int depth;               // nesting level the first time the pass was seen
+        float cpuMs = 0.0f;
+        float gpuMs = 0.0f;
+        float cpuHistory[HISTORY_SIZE] = {};
+        float gpuHistory[HISTORY_SIZE] = {};
+        double cpuAccumMs = 0.0; // this frame so far; a pass may run more than once
+        double gpuAccumMs = 0.0;
+    };
+
+    std::vector<Pass> passes;
+    int cpuHistoryOffset = 0;
+    int gpuHistoryOffset = 0;
+    int droppedGpuFrames = 0;    // frames whose queries were still pending when their slot came round again
+    bool enabled = true;
+
+    static Profiler& Instance() {
+        static Profiler instance;
+        return instance;
+    }
+
+    void BeginFrame() {
+        if (!enabled) return;
+        inFrame = true;
+        depth = 0;
+
+        FrameQueries& slot = frames[frameIndex % GPU_LATENCY];
+        if (slot.pending) {
+            collectGpu(slot);
+        }
+        slot.samples.clear();
+        slot.used = 0;
+        slot.lastQuery = 0;
+        slot.pending = false;
+    }
+
+    void EndFrame() {
+        if (!inFrame) return;
+        inFrame = false;
+
+        for (auto& pass : passes) {
+            pass.cpuMs = (float)pass.cpuAccumMs;
+            pass.cpuHistory[cpuHistoryOffset] = pass.cpuMs;
+            pass.cpuAccumMs = 0.0;
+        }
+        cpuHistoryOffset = (cpuHistoryOffset + 1) % HISTORY_SIZE;
+
+        FrameQueries& slot = frames[frameIndex % GPU_LATENCY];
+        slot.pending = slot.lastQuery != 0;
+        frameIndex++;
+    }
+
+    // Returns the sample index for EndScope, or -1 when nothing is being recorded
+    int BeginScope(const char* name, int& passIndex) {
+        if (!inFrame) {
+            passIndex = -1;
+            return -1;
+        }
+
+        passIndex = findPass(name);
+        depth++;
+
+        FrameQueries& slot = frames[frameIndex % GPU_LATENCY];
+        GpuSample sample;
+        sample.pass = passIndex;
+        sample.begin = slot.acquireQuery();
+        sample.end = slot.acquireQuery();
+        glQueryCounter(sample.begin, GL_TIMESTAMP);
+        slot.samples.push_back(sample);
+        return (int)slot.samples.size() - 1;
+    }
+
+    void EndScope(int passIndex, int sampleIndex, double cpuMs) {
+        if (passIndex < 0 || !inFrame) return;
+
+        depth--;
+        passes[passIndex].cpuAccumMs += cpuMs;
+
+        FrameQueries& slot = frames[frameIndex % GPU_LATENCY];
+        glQueryCounter(slot.samples[sampleIndex].end, GL_TIMESTAMP);
+        slot.lastQuery = slot.samples[sampleIndex].end;
+    }
+
+    // Release the query objects; call while the GL context is still current
+    void Shutdown() {
+        for (auto& slot : frames) {
+            if (!slot.queries.empty()) {
+                glDeleteQueries((GLsizei)slot.queries.size(), slot.queries.data());
+            }
+            slot.queries.clear();
+            slot.samples.clear();
+            slot.used = 0;
+            slot.lastQuery = 0;
+            slot.pending = false;
+        }
+        inFrame = false;
+    }
+
+private:
+    struct GpuSample {
+        int pass;
+        GLuint begin;
+        GLuint end;
+    };
+
+    struct FrameQueries {
+        std::vector<GLuint> queries; // pooled, reused every time this slot comes round
+        std::vector<GpuSample> samples;
+        size_t used = 0;
+        GLuint lastQuery = 0; // the last timestamp issued; scopes nest, so not samples.back().end
+        bool pending = false;
+
+        GLuint acquireQuery() {
+            if (used == queries.size()) {
+                GLuint query;
+                glGenQueries(1, &query);
+                queries.push_back(query);
+            }
+            return queries[used++];
+        }
+    };
+
+    FrameQueries frames[GPU_LATENCY];
+    unsigned int frameIndex = 0;
+    int depth = 0;
+    bool inFrame = false;
+
+    Profiler() {}
+
+    int findPass(const char* name) {
+        for (size_t i = 0; i < passes.size(); i++) {
+            if (passes[i].name == name || strcmp(passes[i].name, name) == 0) return (int)i;
+        }
+        Pass pass;
+        pass.name = name;
+        pass.depth = depth;
+        passes.push_back(pass);
+        return (int)passes.size() - 1;
+    }
+
+    // Read a finished frame's timestamps; if the GPU is still behind, drop the frame rather than
+    // wait. Timestamps complete in issue order, so the last one issued covers every sample
+    void collectGpu(FrameQueries& slot) {
+        GLint available = 0;
+        glGetQueryObjectiv(slot.lastQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+
+        if (available) {
+            for (const auto& sample : slot.samples) {
+                GLuint64 begin = 0, end = 0;
+                glGetQueryObjectui64v(sample.begin, GL_QUERY_RESULT, &begin);
+                glGetQueryObjectui64v(sample.end, GL_QUERY_RESULT, &end);
+                passes[sample.pass].gpuAccumMs += (double)(end - begin) / 1000000.0;
+            }
+
+            for (auto& pass : passes) {
+                pass.gpuMs = (float)pass.gpuAccumMs;
+                pass.gpuHistory[gpuHistoryOffset] = pass.gpuMs;
+                pass.gpuAccumMs = 0.0;
+            }
+            gpuHistoryOffset = (gpuHistoryOffset + 1) % HISTORY_SIZE;
+        } else {
+            droppedGpuFrames++;
+        }
+    }
+};
+
+// Times the enclosing block on the CPU and GPU under name (use a string literal); the block
+// also shows up in trace captures
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name) : trace(name), start(std::chrono::high_resolution_clock::now()) {
+        sample = Profiler::Instance().BeginScope(name, pass);
+    }
+
+    ~ProfileScope() {
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        Profiler::Instance().EndScope(pass, sample, ms);
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    TraceScope trace;
+    int pass;
+    int sample;
+    std::chrono::high_resolution_clock::time_point start;
+};
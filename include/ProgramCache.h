@@ -0,0 +1,209 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <system_error>
+#include <iostream>
+
+// Not part of the GL 3.3 core loader; defined here for GL 4.1 / ARB_get_program_binary
+#define PSX_GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define PSX_GL_PROGRAM_BINARY_LENGTH           0x8741
+#define PSX_GL_NUM_PROGRAM_BINARY_FORMATS      0x87FE
+
+// shader_cache/<key>.bin: magic, version, binary format, length, key, then the driver blob
+const uint32_t PSXPROGRAM_MAGIC = 0x42585350; // "PSXB"
+const uint32_t PSXPROGRAM_VERSION = 1;
+
+struct PsxProgramHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t binaryFormat;
+    uint32_t binaryLength;
+    uint64_t key;
+};
+
+static_assert(sizeof(PsxProgramHeader) == 24, "PsxProgramHeader layout is part of the file format");
+
+// Saves linked programs with glGetProgramBinary and restores them with glProgramBinary on the
+// next run, skipping compilation. Entries are keyed on the shader sources plus the driver's
+// vendor, renderer and version strings, so a driver update simply misses and recompiles.
+class ProgramCache {
+public:
+    bool enabled = true;
+    int hits = 0;
+    int misses = 0;
+
+    static ProgramCache& Instance() {
+        static ProgramCache instance;
+        return instance;
+    }
+
+    // Resolve the program binary entry points; call once after gladLoadGLLoader with the same loader
+    void Initialize(GLADloadproc loader, const std::string& cacheDirectory = "shader_cache") {
+        directory = cacheDirectory;
+        available = false;
+
+        bool supported = GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 1);
+        if (!supported) {
+            GLint extensionCount = 0;
+            glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+            for (GLint i = 0; i < extensionCount && !supported; i++) {
+                const char* name = (const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+                supported = name && strcmp(name, "GL_ARB_get_program_binary") == 0;
+            }
+        }
+        if (!supported) return;
+
+        getProgramBinary = (GetProgramBinaryProc)loader("glGetProgramBinary");
+        programBinary = (ProgramBinaryProc)loader("glProgramBinary");
+        programParameteri = (ProgramParameteriProc)loader("glProgramParameteri");
+        if (!getProgramBinary || !programBinary || !programParameteri) return;
+
+        // Some drivers expose the entry points but no formats to save in
+        GLint formatCount = 0;
+        glGetIntegerv(PSX_GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+        if (formatCount <= 0) return;
+
+        driverHash = hash(FNV_OFFSET, glString(GL_VENDOR));
+        driverHash = hash(driverHash, glString(GL_RENDERER));
+        driverHash = hash(driverHash, glString(GL_VERSION));
+        available = true;
+    }
+
+    bool IsAvailable() const { return enabled && available; }
+
+    uint64_t Key(const std::string& vertexSource, const std::string& fragmentSource) const {
+        uint64_t key = hash(driverHash, vertexSource);
+        return hash(key, fragmentSource);
+    }
+
+    // Link program from a cached binary; false when there is no usable entry and the caller must compile
+    bool Load(GLuint program, uint64_t key) {
+        if (!IsAvailable()) return false;
+
+        FILE* file = fopen(pathFor(key).c_str(), "rb");
+        if (!file) {
+            misses++;
+            return false;
+        }
+
+        PsxProgramHeader header = {};
+        std::vector<char> binary;
+        bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+                  header.magic == PSXPROGRAM_MAGIC && header.version == PSXPROGRAM_VERSION &&
+                  header.key == key && header.binaryLength > 0;
+        if (ok) {
+            binary.resize(header.binaryLength);
+            ok = fread(binary.data(), 1, binary.size(), file) == binary.size();
+        }
+        fclose(file);
+
+        GLint linked = 0;
+        if (ok) {
+            programBinary(program, (GLenum)header.binaryFormat, binary.data(), (GLsizei)binary.size());
+            glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        }
+
+        // Rejected binaries (driver changed underneath the same version string) are rebuilt and overwritten
+        if (!linked) {
+            misses++;
+            return false;
+        }
+        hits++;
+        return true;
+    }
+
+    // Ask the driver to keep the binary around; call before glLinkProgram
+    void PrepareLink(GLuint program) {
+        if (IsAvailable()) programParameteri(program, PSX_GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    // Save a freshly linked program
+    bool Store(GLuint program, uint64_t key) {
+        if (!IsAvailable()) return false;
+
+        GLint length = 0;
+        glGetProgramiv(program, PSX_GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0) return false;
+
+        std::vector<char> binary(length);
+        GLenum format = 0;
+        GLsizei written = 0;
+        getProgramBinary(program, length, &written, &format, binary.data());
+        if (written <= 0) return false;
+
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+
+        PsxProgramHeader header;
+        header.magic = PSXPROGRAM_MAGIC;
+        header.version = PSXPROGRAM_VERSION;
+        header.binaryFormat = (uint32_t)format;
+        header.binaryLength = (uint32_t)written;
+        header.key = key;
+
+        // Write to a temporary name first so a crash never leaves a truncated entry behind
+        std::string path = pathFor(key);
+        std::string tempPath = path + ".tmp";
+        FILE* file = fopen(tempPath.c_str(), "wb");
+        if (!file) {
+            std::cout << "Failed to write program cache: " << path << std::endl;
+            return false;
+        }
+
+        bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+        if (ok) ok = fwrite(binary.data(), 1, (size_t)written, file) == (size_t)written;
+        ok = (fclose(file) == 0) && ok;
+
+        if (ok) std::filesystem::rename(tempPath, path, ec);
+        if (!ok || ec) {
+            std::remove(tempPath.c_str());
+            std::cout << "Failed to write program cache: " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    typedef void (APIENTRYP GetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+    typedef void (APIENTRYP ProgramBinaryProc)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+    typedef void (APIENTRYP ProgramParameteriProc)(GLuint program, GLenum pname, GLint value);
+
+    static const uint64_t FNV_OFFSET = 14695981039346656037ull;
+    static const uint64_t FNV_PRIME = 1099511628211ull;
+
+    GetProgramBinaryProc getProgramBinary = nullptr;
+    ProgramBinaryProc programBinary = nullptr;
+    ProgramParameteriProc programParameteri = nullptr;
+
+    std::string directory = "shader_cache";
+    uint64_t driverHash = FNV_OFFSET;
+    bool available = false;
+
+    ProgramCache() {}
+
+    // FNV-1a; the terminating zero is hashed too so "ab"+"c" and "a"+"bc" differ
+    static uint64_t hash(uint64_t h, const std::string& text) {
+        for (size_t i = 0; i <= text.size(); i++) {
+            h ^= (unsigned char)text.c_str()[i];
+            h *= FNV_PRIME;
+        }
+        return h;
+    }
+
+    static std::string glString(GLenum name) {
+        const char* value = (const char*)glGetString(name);
+        return value ? value : "";
+    }
+
+    std::string pathFor(uint64_t key) const {
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+        return directory + "/" + name;
+    }
+};
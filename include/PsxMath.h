@@ -0,0 +1,287 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PSX_MATH_SSE 1
+#endif
+
+// Shared vector and matrix math. Matrices are column-major (m[col * 4 + row]) as uploaded
+// to GL. Every SIMD routine has a *Scalar twin computing the same thing without
+// intrinsics; the SSE paths must agree with them to float rounding.
+
+struct alignas(16) vec3 {
+    float x, y, z, pad; // pad keeps 16-byte loads in bounds; its value is unspecified
+
+    vec3() : x(0.0f), y(0.0f), z(0.0f), pad(0.0f) {}
+    vec3(float x, float y, float z) : x(x), y(y), z(z), pad(0.0f) {}
+    explicit vec3(const float* v) : x(v[0]), y(v[1]), z(v[2]), pad(0.0f) {}
+
+    void Store(float* out) const { out[0] = x; out[1] = y; out[2] = z; }
+};
+
+struct alignas(16) vec4 {
+    float x, y, z, w;
+
+    vec4() : x(0.0f), y(0.0f), z(0.0f), w(0.0f) {}
+    vec4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+};
+
+struct alignas(16) quat {
+    float x, y, z, w;
+
+    quat() : x(0.0f), y(0.0f), z(0.0f), w(1.0f) {}
+    quat(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+};
+
+struct alignas(16) mat4 {
+    float m[16];
+
+    static mat4 Identity() {
+        mat4 result;
+        for (int i = 0; i < 16; i++) result.m[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+        return result;
+    }
+
+    static mat4 Load(const float* values) {
+        mat4 result;
+        for (int i = 0; i < 16; i++) result.m[i] = values[i];
+        return result;
+    }
+
+    void Store(float* out) const {
+        for (int i = 0; i < 16; i++) out[i] = m[i];
+    }
+};
+
+inline vec3 operator+(const vec3& a, const vec3& b) { return vec3(a.x + b.x, a.y + b.y, a.z + b.z); }
+inline vec3 operator-(const vec3& a, const vec3& b) { return vec3(a.x - b.x, a.y - b.y, a.z - b.z); }
+inline vec3 operator*(const vec3& a, float s) { return vec3(a.x * s, a.y * s, a.z * s); }
+
+inline float Dot(const vec3& a, const vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+inline float Length(const vec3& v) { return sqrtf(Dot(v, v)); }
+
+inline vec3 Cross(const vec3& a, const vec3& b) {
+    return vec3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+inline vec3 Normalize(const vec3& v) {
+    float length = Length(v);
+    return length > 0.0f ? v * (1.0f / length) : v;
+}
+
+// float[3] forms for code that keeps plain arrays (Camera, lights); out may alias the inputs
+inline void Cross3(const float* a, const float* b, float* out) {
+    vec3 result = Cross(vec3(a), vec3(b));
+    result.Store(out);
+}
+
+inline void Normalize3(const float* v, float* out) {
+    Normalize(vec3(v)).Store(out);
+}
+
+inline float Radians(float degrees) {
+    return degrees * 3.14159265359f / 180.0f;
+}
+
+// q = qy * qx * qz: rotation applies Z, then X, then Y (radians)
+inline quat QuatFromEuler(float x, float y, float z) {
+    float sx = sinf(x * 0.5f), cx = cosf(x * 0.5f);
+    float sy = sinf(y * 0.5f), cy = cosf(y * 0.5f);
+    float sz = sinf(z * 0.5f), cz = cosf(z * 0.5f);
+    return quat(cy * sx * cz + sy * cx * sz,
+                sy * cx * cz - cy * sx * sz,
+                cy * cx * sz - sy * sx * cz,
+                cy * cx * cz + sy * sx * sz);
+}
+
+// T * R * S
+inline mat4 Mat4FromTRS(const vec3& t, const quat& q, const vec3& s) {
+    float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+    float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+    mat4 r;
+    r.m[0] = (1.0f - 2.0f * (yy + zz)) * s.x;
+    r.m[1] = 2.0f * (xy + wz) * s.x;
+    r.m[2] = 2.0f * (xz - wy) * s.x;
+    r.m[3] = 0.0f;
+    r.m[4] = 2.0f * (xy - wz) * s.y;
+    r.m[5] = (1.0f - 2.0f * (xx + zz)) * s.y;
+    r.m[6] = 2.0f * (yz + wx) * s.y;
+    r.m[7] = 0.0f;
+    r.m[8] = 2.0f * (xz + wy) * s.z;
+    r.m[9] = 2.0f * (yz - wx) * s.z;
+    r.m[10] = (1.0f - 2.0f * (xx + yy)) * s.z;
+    r.m[11] = 0.0f;
+    r.m[12] = t.x;
+    r.m[13] = t.y;
+    r.m[14] = t.z;
+    r.m[15] = 1.0f;
+    return r;
+}
+
+// OpenGL-style projection; fovy in degrees
+inline mat4 Mat4Perspective(float fovy, float aspect, float zNear, float zFar) {
+    float f = 1.0f / tanf(fovy * 3.14159265359f / 360.0f);
+    mat4 r;
+    r.m[0] = f / aspect; r.m[4] = 0; r.m[8] = 0; r.m[12] = 0;
+    r.m[1] = 0; r.m[5] = f; r.m[9] = 0; r.m[13] = 0;
+    r.m[2] = 0; r.m[6] = 0; r.m[10] = (zFar + zNear) / (zNear - zFar); r.m[14] = (2 * zFar * zNear) / (zNear - zFar);
+    r.m[3] = 0; r.m[7] = 0; r.m[11] = -1; r.m[15] = 0;
+    return r;
+}
+
+inline mat4 Mat4LookAt(const vec3& eye, const vec3& center, const vec3& up) {
+    vec3 f = Normalize(center - eye);
+    vec3 s = Normalize(Cross(f, up));
+    vec3 u = Cross(s, f);
+
+    mat4 r;
+    r.m[0] = s.x; r.m[4] = s.y; r.m[8] = s.z; r.m[12] = -Dot(s, eye);
+    r.m[1] = u.x; r.m[5] = u.y; r.m[9] = u.z; r.m[13] = -Dot(u, eye);
+    r.m[2] = -f.x; r.m[6] = -f.y; r.m[10] = -f.z; r.m[14] = Dot(f, eye);
+    r.m[3] = 0; r.m[7] = 0; r.m[11] = 0; r.m[15] = 1;
+    return r;
+}
+
+inline mat4 Mat4MultiplyScalar(const mat4& a, const mat4& b) {
+    mat4 r;
+    for (int col = 0; col < 4; col++) {
+        for (int row = 0; row < 4; row++) {
+            r.m[col * 4 + row] = a.m[0 * 4 + row] * b.m[col * 4 + 0] +
+                                 a.m[1 * 4 + row] * b.m[col * 4 + 1] +
+                                 a.m[2 * 4 + row] * b.m[col * 4 + 2] +
+                                 a.m[3 * 4 + row] * b.m[col * 4 + 3];
+        }
+    }
+    return r;
+}
+
+// a * b: applies b first
+inline mat4 Mat4Multiply(const mat4& a, const mat4& b) {
+#ifdef PSX_MATH_SSE
+    __m128 c0 = _mm_load_ps(a.m + 0), c1 = _mm_load_ps(a.m + 4);
+    __m128 c2 = _mm_load_ps(a.m + 8), c3 = _mm_load_ps(a.m + 12);
+    mat4 r;
+    for (int col = 0; col < 4; col++) {
+        const float* bc = b.m + col * 4;
+        __m128 sum = _mm_mul_ps(c0, _mm_set1_ps(bc[0]));
+        sum = _mm_add_ps(sum, _mm_mul_ps(c1, _mm_set1_ps(bc[1])));
+        sum = _mm_add_ps(sum, _mm_mul_ps(c2, _mm_set1_ps(bc[2])));
+        sum = _mm_add_ps(sum, _mm_mul_ps(c3, _mm_set1_ps(bc[3])));
+        _mm_store_ps(r.m + col * 4, sum);
+    }
+    return r;
+#else
+    return Mat4MultiplyScalar(a, b);
+#endif
+}
+
+inline void TransformPointsScalar(const mat4& m, const vec3* points, vec3* out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        const vec3& p = points[i];
+        out[i] = vec3(m.m[0] * p.x + m.m[4] * p.y + m.m[8] * p.z + m.m[12],
+                      m.m[1] * p.x + m.m[5] * p.y + m.m[9] * p.z + m.m[13],
+                      m.m[2] * p.x + m.m[6] * p.y + m.m[10] * p.z + m.m[14]);
+    }
+}
+
+// Affine transform of count points; out may equal points
+inline void TransformPoints(const mat4& m, const vec3* points, vec3* out, size_t count) {
+#ifdef PSX_MATH_SSE
+    __m128 c0 = _mm_load_ps(m.m + 0), c1 = _mm_load_ps(m.m + 4);
+    __m128 c2 = _mm_load_ps(m.m + 8), c3 = _mm_load_ps(m.m + 12);
+    for (size_t i = 0; i < count; i++) {
+        const vec3& p = points[i];
+        __m128 r = _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(p.x)), c3);
+        r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_set1_ps(p.y)));
+        r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(p.z)));
+        _mm_store_ps(&out[i].x, r);
+    }
+#else
+    TransformPointsScalar(m, points, out, count);
+#endif
+}
+
+// World-space box of a local box under an affine matrix (Arvo's method)
+inline void TransformAABBScalar(const float* localMin, const float* localMax, const float* m,
+                                float* outMin, float* outMax) {
+    for (int row = 0; row < 3; row++) {
+        outMin[row] = outMax[row] = m[12 + row];
+        for (int col = 0; col < 3; col++) {
+            float a = m[col * 4 + row] * localMin[col];
+            float b = m[col * 4 + row] * localMax[col];
+            outMin[row] += a < b ? a : b;
+            outMax[row] += a < b ? b : a;
+        }
+    }
+}
+
+inline void TransformAABB(const float* localMin, const float* localMax, const float* m,
+                          float* outMin, float* outMax) {
+#ifdef PSX_MATH_SSE
+    __m128 lo = _mm_loadu_ps(m + 12), hi = lo;
+    for (int col = 0; col < 3; col++) {
+        __m128 column = _mm_loadu_ps(m + col * 4);
+        __m128 a = _mm_mul_ps(column, _mm_set1_ps(localMin[col]));
+        __m128 b = _mm_mul_ps(column, _mm_set1_ps(localMax[col]));
+        lo = _mm_add_ps(lo, _mm_min_ps(a, b));
+        hi = _mm_add_ps(hi, _mm_max_ps(a, b));
+    }
+    alignas(16) float loOut[4], hiOut[4];
+    _mm_store_ps(loOut, lo);
+    _mm_store_ps(hiOut, hi);
+    for (int i = 0; i < 3; i++) {
+        outMin[i] = loOut[i];
+        outMax[i] = hiOut[i];
+    }
+#else
+    TransformAABBScalar(localMin, localMax, m, outMin, outMax);
+#endif
+}
+
+// count boxes, each under its own matrix (16 floats apart); mins/maxs are 3 floats per box
+inline void TransformAABBs(const float* localMins, const float* localMaxs, const float* matrices,
+                           float* outMins, float* outMaxs, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        TransformAABB(localMins + i * 3, localMaxs + i * 3, matrices + i * 16, outMins + i * 3, outMaxs + i * 3);
+    }
+}
+
+#ifdef PSX_MATH_SSE
+// sin and cos of four angles: reduce to [-pi/4, pi/4] by quadrant, then the Cephes polynomials
+inline void SinCos4(__m128 x, __m128& sinOut, __m128& cosOut) {
+    const __m128 twoOverPi = _mm_set1_ps(0.63661977236f);
+    __m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(x, twoOverPi));
+    __m128 j = _mm_cvtepi32_ps(quadrant);
+
+    // x - j * pi/2 in three parts to keep precision
+    __m128 y = _mm_sub_ps(x, _mm_mul_ps(j, _mm_set1_ps(1.5703125f)));
+    y = _mm_sub_ps(y, _mm_mul_ps(j, _mm_set1_ps(4.837512969970703125e-4f)));
+    y = _mm_sub_ps(y, _mm_mul_ps(j, _mm_set1_ps(7.54978995489188216e-8f)));
+
+    __m128 z = _mm_mul_ps(y, y);
+
+    __m128 sinPoly = _mm_set1_ps(-1.9515295891e-4f);
+    sinPoly = _mm_add_ps(_mm_mul_ps(sinPoly, z), _mm_set1_ps(8.3321608736e-3f));
+    sinPoly = _mm_add_ps(_mm_mul_ps(sinPoly, z), _mm_set1_ps(-1.6666654611e-1f));
+    sinPoly = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sinPoly, z), y), y);
+
+    __m128 cosPoly = _mm_set1_ps(2.443315711809948e-5f);
+    cosPoly = _mm_add_ps(_mm_mul_ps(cosPoly, z), _mm_set1_ps(-1.388731625493765e-3f));
+    cosPoly = _mm_add_ps(_mm_mul_ps(cosPoly, z), _mm_set1_ps(4.166664568298827e-2f));
+    cosPoly = _mm_mul_ps(_mm_mul_ps(cosPoly, z), z);
+    cosPoly = _mm_add_ps(_mm_sub_ps(cosPoly, _mm_mul_ps(z, _mm_set1_ps(0.5f))), _mm_set1_ps(1.0f));
+
+    // Odd quadrants swap sin and cos; quadrants 2,3 negate sin and 1,2 negate cos
+    __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+    __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(2)), 30));
+    __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+
+    sinOut = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, cosPoly), _mm_andnot_ps(swap, sinPoly)), sinSign);
+    cosOut = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, sinPoly), _mm_andnot_ps(swap, cosPoly)), cosSign);
+}
+#endif
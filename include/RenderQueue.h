@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <unordered_map>
+#include <utility>
+
+class Model;
+class Texture;
+
+enum class RenderPass : uint8_t {
+    Opaque = 0,
+    Transparent = 1
+};
+
+// One draw waiting in the queue; the matrix points at storage that outlives the frame
+struct RenderItem {
+    Model* model;
+    Texture* texture;
+    const void* textureBinding; // Texture::Binding(), shared by textures on one array page
+    const float* matrix;
+    RenderPass pass;
+    uint8_t lod;
+};
+
+// Visible objects submit a 64-bit sort key and a payload; Sort() radix-sorts the keys so
+// executing the queue in order groups draws by state and orders them by depth.
+//
+// Opaque key, most significant first:
+//   pass:4 | shader:8 | texture:14 | mesh:14 | depth:24      front-to-back inside a state group
+// Transparent key:
+//   pass:4 | far-to-near depth:24 | shader:8 | texture:14 | mesh:14   strictly back-to-front
+// The mesh field is the mesh id with the LOD in its low 2 bits, so each level batches apart.
+// The texture field identifies the texture's binding, so packed textures that share an
+// array page sort together and can batch.
+class RenderQueue {
+public:
+    static const int DEPTH_BITS = 24;
+    static const uint32_t DEPTH_MAX = (1u << DEPTH_BITS) - 1;
+    static const int LOD_BITS = 2; // low bits of the mesh field
+
+    struct Entry {
+        uint64_t key;
+        uint32_t item;
+    };
+
+    std::vector<RenderItem> items;
+    std::vector<Entry> entries; // sorted by Sort()
+
+    // Distance mapped onto the 24 depth bits; anything further shares the last bucket
+    float maxDepth = 100.0f;
+
+    // Ids are only compared within one frame, so they restart here; nothing is kept for
+    // models or textures that have since been destroyed
+    void Clear() {
+        items.clear();
+        entries.clear();
+        textureIds.clear();
+        meshIds.clear();
+    }
+
+    // depth is the view-space distance in front of the camera; shader picks the program variant
+    void Submit(RenderPass pass, uint8_t shader, Model* model, Texture* texture, const void* textureBinding,
+                const float* matrix, float depth, uint8_t lod = 0) {
+        uint64_t textureId = idFor(textureIds, textureBinding) & 0x3FFF;
+        uint64_t meshId = (((uint64_t)idFor(meshIds, model) << LOD_BITS) | lod) & 0x3FFF;
+        uint64_t quantized = quantizeDepth(depth);
+        uint64_t state = ((uint64_t)shader << 28) | (textureId << 14) | meshId;
+
+        Entry entry;
+        if (pass == RenderPass::Opaque) {
+            entry.key = ((uint64_t)pass << 60) | (state << 24) | quantized;
+        } else {
+            entry.key = ((uint64_t)pass << 60) | ((DEPTH_MAX - quantized) << 36) | state;
+        }
+        entry.item = (uint32_t)items.size();
+        entries.push_back(entry);
+
+        RenderItem item;
+        item.model = model;
+        item.texture = texture;
+        item.textureBinding = textureBinding;
+        item.matrix = matrix;
+        item.pass = pass;
+        item.lod = lod;
+        items.push_back(item);
+    }
+
+    // LSD radix sort, one byte per pass; bytes that are the same in every key are skipped,
+    // which for a typical frame leaves only the depth and id bytes
+    void Sort() {
+        size_t count = entries.size();
+        if (count < 2) return;
+
+        uint32_t histograms[8][256];
+        memset(histograms, 0, sizeof(histograms));
+        for (const Entry& entry : entries) {
+            for (int digit = 0; digit < 8; digit++) {
+                histograms[digit][(entry.key >> (digit * 8)) & 0xFF]++;
+            }
+        }
+
+        scratch.resize(count);
+        Entry* source = entries.data();
+        Entry* target = scratch.data();
+
+        for (int digit = 0; digit < 8; digit++) {
+            uint32_t* histogram = histograms[digit];
+            if (histogram[(source[0].key >> (digit * 8)) & 0xFF] == count) continue;
+
+            uint32_t offset = 0;
+            for (int bucket = 0; bucket < 256; bucket++) {
+                uint32_t bucketCount = histogram[bucket];
+                histogram[bucket] = offset;
+                offset += bucketCount;
+            }
+            for (size_t i = 0; i < count; i++) {
+                const Entry& entry = source[i];
+                target[histogram[(entry.key >> (digit * 8)) & 0xFF]++] = entry;
+            }
+            std::swap(source, target);
+        }
+
+        if (source != entries.data()) {
+            memcpy(entries.data(), source, count * sizeof(Entry));
+        }
+    }
+
+    const RenderItem& ItemAt(size_t sortedIndex) const {
+        return items[entries[sortedIndex].item];
+    }
+
+    size_t Size() const { return entries.size(); }
+
+private:
+    std::vector<Entry> scratch;
+
+    // Small ids keep the key compact; assigned on first sight each frame. Past 4095 meshes or
+    // 16383 bindings in one frame ids wrap and share keys, which costs batching but not
+    // correctness: ExecuteQueue still breaks runs on the actual model and binding
+    std::unordered_map<const void*, uint32_t> textureIds;
+    std::unordered_map<const void*, uint32_t> meshIds;
+
+    static uint32_t idFor(std::unordered_map<const void*, uint32_t>& ids, const void* pointer) {
+        if (!pointer) return 0;
+        auto it = ids.find(pointer);
+        if (it != ids.end()) return it->second;
+        uint32_t id = (uint32_t)ids.size() + 1;
+        ids[pointer] = id;
+        return id;
+    }
+
+    uint64_t quantizeDepth(float depth) const {
+        if (!(depth > 0.0f)) return 0;
+        if (depth >= maxDepth) return DEPTH_MAX;
+        return (uint64_t)(depth / maxDepth * (float)DEPTH_MAX);
+    }
+};
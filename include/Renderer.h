@@ -4,14 +4,21 @@
 #include <iostream>
 #include "Shader.h"
 #include "Camera.h"
-#include "Model.h"
+#include "model.h"
 #include "Texture.h"
 #include "Lighting.h"
 #include "ParticleSystem.h"
 #include "PostProcess.h"
 #include "ShadowMap.h"
 #include "Skybox.h"
+#include "FrameConstants.h"
+#include "Frustum.h"
+#include "Profiler.h"
+#include "GLState.h"
+#include "RenderQueue.h"
+#include "Transform.h"
 #include <vector>
+#include <cstring>
 
 struct FogSettings {
     float start = 2.0f;
@@ -21,16 +28,22 @@ struct FogSettings {
     float color[3] = {0.05f, 0.02f, 0.08f};
 };
 
-struct Transform {
-    float position[3] = {0.0f, 0.0f, 0.0f};
-    float rotation[3] = {0.0f, 0.0f, 0.0f};
-    float scale[3] = {1.0f, 1.0f, 1.0f};
-    
-    void GetMatrix(float* result) const {
-        result[0] = scale[0]; result[4] = 0; result[8] = 0; result[12] = position[0];
-        result[1] = 0; result[5] = scale[1]; result[9] = 0; result[13] = position[1];
-        result[2] = 0; result[6] = 0; result[10] = scale[2]; result[14] = position[2];
-        result[3] = 0; result[7] = 0; result[11] = 0; result[15] = 1;
+// Screen-size LOD selection. An object drops to LOD n + 1 once its bounding sphere projects
+// smaller than thresholds[n] pixels tall at renderHeight; hysteresis is the fraction it must
+// move past a threshold before the level changes, so objects near one do not pop every frame.
+static_assert(Model::MAX_LODS <= (1 << RenderQueue::LOD_BITS), "LOD levels must fit the queue key's LOD bits");
+
+struct LodSettings {
+    bool enabled = true;
+    float thresholds[Model::MAX_LODS - 1] = {96.0f, 48.0f, 24.0f};
+    float hysteresis = 0.15f;
+
+    int Select(int current, int lodCount, float pixelSize) const {
+        if (!enabled || lodCount < 2) return 0;
+        int lod = current < lodCount ? current : lodCount - 1;
+        while (lod < lodCount - 1 && pixelSize < thresholds[lod] * (1.0f - hysteresis)) lod++;
+        while (lod > 0 && pixelSize > thresholds[lod - 1] * (1.0f + hysteresis)) lod--;
+        return lod;
     }
 };
 
@@ -39,41 +52,47 @@ struct RenderObject {
     Texture* texture;
     Transform transform;
     bool useTexture = false;
+    bool transparent = false; // alpha blended, drawn back-to-front after all opaque objects
+    uint8_t lod = 0;          // level chosen last frame, kept for hysteresis
+};
+
+// Work submitted in the current frame, reset by BeginFrame
+struct RenderStats {
+    int drawCalls = 0;
+    long long triangles = 0;
+    int instances = 0;
+    int lodObjects[Model::MAX_LODS] = {}; // queued objects drawn at each level
 };
 
 class PSXRenderer {
 public:
     Shader* psxShader;
     FogSettings fog;
+    LodSettings lod;
     LightingSystem lighting;
     ParticleSystem* particles;
     PostProcessEffect* postProcess;
     ShadowMap* shadowMap;
     float vertexSnapResolution = 64.0f;
     Skybox* skybox;
+    FrameConstantsBuffer frameConstants;
+    Frustum frustum;
+    RenderStats stats;
+    bool cullBeyondFog = true; // objects past fog.end are pure fog colour, skip them
     
     float currentAspectRatio = 320.0f / 240.0f;
     int renderWidth = 320;
     int renderHeight = 240;
     
-    PSXRenderer() : psxShader(nullptr), particles(nullptr), postProcess(nullptr), shadowMap(nullptr), skybox(nullptr) {}
+    PSXRenderer() : psxShader(nullptr), particles(nullptr), postProcess(nullptr), shadowMap(nullptr), skybox(nullptr), instanceVBO(0), instanceCapacity(0) {}
     
     bool Initialize() {
-        std::string vertexSource = R"(
-            #version 330 core
-            layout (location = 0) in vec3 aPos;
-            layout (location = 1) in vec3 aColor;
-            layout (location = 2) in vec2 aTexCoord;
-            
-            uniform mat4 model;
-            uniform mat4 view;
-            uniform mat4 projection;
-            uniform float u_snapResolution;
-            uniform float fogStart;
-            uniform float fogEnd;
-            uniform float fogHeightStart;
-            uniform float fogHeightEnd;
+        std::string vertexSource = std::string(R"(
+            #version 330 core)") + FRAME_CONSTANTS_GLSL + PACKED_VERTEX_GLSL + R"(
+            layout (location = 3) in mat4 aInstanceModel;
+            layout (location = 8) in vec4 aInstanceMaterial; // array layer, width, height
             
+            flat out vec3 material;
             out vec3 vertexColor;
             out vec2 TexCoord;
             out float fogFactor;
@@ -82,7 +101,8 @@ public:
             out vec3 Normal;
             
             void main() {
-                vec4 worldPos = model * vec4(aPos, 1.0);
+                mat4 model = aInstanceModel;
+                vec4 worldPos = model * vec4(decodePosition(), 1.0);
                 vec4 viewPos = view * worldPos;
                 vec4 clipPos = projection * viewPos;
                 
@@ -98,53 +118,72 @@ public:
                 
                 fogFactor = min(distanceFog, heightFog);
                 
-                // Basic normal calculation (assuming uniform scaling)
-                Normal = normalize(mat3(model) * vec3(0.0, 1.0, 0.0)); // Simple upward normal for now
+                // Assumes uniform scaling
+                Normal = normalize(mat3(model) * decodeNormal());
                 
                 gl_Position = clipPos;
                 vertexColor = aColor;
-                TexCoord = aTexCoord;
+                TexCoord = decodeTexCoord();
+                material = aInstanceMaterial.xyz;
                 FragPos = viewPos.xyz;
                 WorldPos = worldPos.xyz;
             }
         )";
 
-        std::string fragmentSource = R"(
-            #version 330 core
+        std::string fragmentSource = std::string(R"(
+            #version 330 core)") + FRAME_CONSTANTS_GLSL + R"(
             in vec3 vertexColor;
             in vec2 TexCoord;
             in float fogFactor;
             in vec3 FragPos;
             in vec3 WorldPos;
             in vec3 Normal;
+            flat in vec3 material;
             out vec4 FragColor;
             
             uniform sampler2D ourTexture;
             uniform bool useTexture;
-            uniform vec3 fogColor;
             
-            // Spotlight
-            uniform bool spotlightEnabled;
-            uniform vec3 spotlightPos;
-            uniform vec3 spotlightDir;
-            uniform vec3 spotlightColor;
-            uniform float spotlightIntensity;
-            uniform float spotlightRange;
-            uniform float spotlightInnerCone;
-            uniform float spotlightOuterCone;
+            // CLUT textures: ourTexture holds palette indices, u_palette the colours
+            uniform sampler2D u_palette;
+            uniform int u_clutBits;   // 0 = direct colour, 4 or 8
+            uniform int u_clutWidth;  // image width in texels
             
-            // Directional Light
-            uniform bool directionalEnabled;
-            uniform vec3 directionalDir;
-            uniform vec3 directionalColor;
-            uniform float directionalIntensity;
+            // Packed textures: the draw binds an array page, each instance names its layer
+            // and real size in material; CLUT pages keep one palette row per layer
+            uniform bool u_textureArray;
+            uniform sampler2DArray u_layers;
+            uniform sampler2D u_paletteRows;
             
-            // Ambient Light
-            uniform vec3 ambientColor;
-            uniform float ambientIntensity;
+            // Stored CLUT texel at an image texel; 4bpp stores two per byte, low nibble first
+            int clutIndex(float stored, int x) {
+                int value = int(stored * 255.0 + 0.5);
+                if (u_clutBits == 4) return (x & 1) == 1 ? value >> 4 : value & 15;
+                return value;
+            }
+            
+            // Indices must not be filtered and layers are padded, so both fetch texels
+            // directly; fract() stands in for GL_REPEAT
+            vec4 sampleTexture(vec2 uv) {
+                if (u_textureArray) {
+                    int layer = int(material.x);
+                    ivec2 size = ivec2(material.yz);
+                    ivec2 texel = min(ivec2(fract(uv) * vec2(size)), size - 1);
+                    if (u_clutBits == 0) return texelFetch(u_layers, ivec3(texel, layer), 0);
+                    ivec2 stored = u_clutBits == 4 ? ivec2(texel.x >> 1, texel.y) : texel;
+                    int index = clutIndex(texelFetch(u_layers, ivec3(stored, layer), 0).r, texel.x);
+                    return texelFetch(u_paletteRows, ivec2(index, layer), 0);
+                }
+                if (u_clutBits == 0) return texture(ourTexture, uv);
+                ivec2 size = ivec2(u_clutWidth, textureSize(ourTexture, 0).y);
+                ivec2 texel = min(ivec2(fract(uv) * vec2(size)), size - 1);
+                ivec2 stored = u_clutBits == 4 ? ivec2(texel.x >> 1, texel.y) : texel;
+                int index = clutIndex(texelFetch(ourTexture, stored, 0).r, texel.x);
+                return texelFetch(u_palette, ivec2(index, 0), 0);
+            }
             
             void main() {
-                vec4 texColor = texture(ourTexture, TexCoord);
+                vec4 texColor = sampleTexture(TexCoord);
                 vec4 baseColor;
                 
                 if (useTexture) {
@@ -200,7 +239,27 @@ public:
             }
         )";
         
+        frameConstants.Initialize();
+        
         psxShader = new Shader(vertexSource, fragmentSource, true);
+        useTextureUniform = psxShader->getUniform<bool>("useTexture");
+        meshOffsetUniform = psxShader->getUniform<UniformVec3>("u_meshOffset");
+        meshScaleUniform = psxShader->getUniform<UniformVec3>("u_meshScale");
+        textureUniform = psxShader->getUniform<int>("ourTexture");
+        paletteUniform = psxShader->getUniform<int>("u_palette");
+        clutBitsUniform = psxShader->getUniform<int>("u_clutBits");
+        clutWidthUniform = psxShader->getUniform<int>("u_clutWidth");
+        textureArrayUniform = psxShader->getUniform<bool>("u_textureArray");
+        
+        // Sampler types may not share a unit, so every sampler gets a fixed one up front
+        psxShader->use();
+        psxShader->set(textureUniform, 0);
+        psxShader->set(paletteUniform, 1);
+        psxShader->setInt("u_layers", 2);
+        psxShader->setInt("u_paletteRows", 3);
+        
+        glGenBuffers(1, &instanceVBO);
+
         particles = new ParticleSystem(2000);
         postProcess = new PostProcessEffect(renderWidth, renderHeight);
         shadowMap = new ShadowMap();
@@ -224,78 +283,139 @@ public:
     }
     
     void BeginFrame(Camera& camera) {
+        ProfileScope scope("BeginFrame");
+        stats = RenderStats();
+        GLState::Instance().ResetStats();
         postProcess->BeginRender();
         glClearColor(fog.color[0], fog.color[1], fog.color[2], 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        skybox->Render(camera, currentAspectRatio);
-        
         lighting.SetFlashlightFromCamera(camera.Position, camera.Front);
+        UpdateFrameConstants(camera);
         
+        skybox->Render();
+        
+        SetOpaqueState();
         psxShader->use();
-        psxShader->setFloat("u_snapResolution", vertexSnapResolution);
+    }
+    
+    // Depth-tested, depth-writing, unblended: what opaque queue items expect
+    void SetOpaqueState() {
+        GLState& state = GLState::Instance();
+        state.SetBlend(false);
+        state.SetDepthTest(true);
+        state.DepthFunc(GL_LESS);
+        state.DepthMask(true);
+    }
+    
+    // Blended over the opaque scene, depth-tested but not writing depth
+    void SetTransparentState() {
+        GLState& state = GLState::Instance();
+        state.SetBlend(true);
+        state.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        state.SetDepthTest(true);
+        state.DepthFunc(GL_LESS);
+        state.DepthMask(false);
+    }
+    
+    // Fill the shared per-frame block once; every PSX program reads it from FRAME_CONSTANTS_BINDING
+    void UpdateFrameConstants(Camera& camera) {
+        FrameConstants& fc = frameConstants.data;
+        
+        camera.GetViewMatrix(fc.view);
+        Mat4Perspective(camera.Fov, currentAspectRatio, 0.1f, 100.0f).Store(fc.projection);
+        copy3(fc.cameraPos, camera.Position);
+        fc.time = skybox->totalTime;
+        
+        fc.fogStart = fog.start;
+        fc.fogEnd = fog.end;
+        fc.fogHeightStart = fog.heightStart;
+        fc.fogHeightEnd = fog.heightEnd;
+        copy3(fc.fogColor, fog.color);
+        fc.snapResolution = vertexSnapResolution;
         
-        // Fog uniforms
-        psxShader->setFloat("fogStart", fog.start);
-        psxShader->setFloat("fogEnd", fog.end);
-        psxShader->setFloat("fogHeightStart", fog.heightStart);
-        psxShader->setFloat("fogHeightEnd", fog.heightEnd);
-        psxShader->setVec3("fogColor", fog.color[0], fog.color[1], fog.color[2]);
+        fc.spotlightEnabled = lighting.spotlight.enabled;
+        copy3(fc.spotlightPos, lighting.spotlight.position);
+        copy3(fc.spotlightDir, lighting.spotlight.direction);
+        copy3(fc.spotlightColor, lighting.spotlight.color);
+        fc.spotlightIntensity = lighting.spotlight.intensity;
+        fc.spotlightRange = lighting.spotlight.range;
+        fc.spotlightInnerCone = lighting.spotlight.innerCone;
+        fc.spotlightOuterCone = lighting.spotlight.outerCone;
         
-        // Spotlight uniforms
-        psxShader->setBool("spotlightEnabled", lighting.spotlight.enabled);
-        psxShader->setVec3("spotlightPos", lighting.spotlight.position[0], lighting.spotlight.position[1], lighting.spotlight.position[2]);
-        psxShader->setVec3("spotlightDir", lighting.spotlight.direction[0], lighting.spotlight.direction[1], lighting.spotlight.direction[2]);
-        psxShader->setVec3("spotlightColor", lighting.spotlight.color[0], lighting.spotlight.color[1], lighting.spotlight.color[2]);
-        psxShader->setFloat("spotlightIntensity", lighting.spotlight.intensity);
-        psxShader->setFloat("spotlightRange", lighting.spotlight.range);
-        psxShader->setFloat("spotlightInnerCone", lighting.spotlight.innerCone);
-        psxShader->setFloat("spotlightOuterCone", lighting.spotlight.outerCone);
+        fc.directionalEnabled = lighting.directional.enabled;
+        copy3(fc.directionalDir, lighting.directional.direction);
+        copy3(fc.directionalColor, lighting.directional.color);
+        fc.directionalIntensity = lighting.directional.intensity;
         
-        // Directional light uniforms
-        psxShader->setBool("directionalEnabled", lighting.directional.enabled);
-        psxShader->setVec3("directionalDir", lighting.directional.direction[0], lighting.directional.direction[1], lighting.directional.direction[2]);
-        psxShader->setVec3("directionalColor", lighting.directional.color[0], lighting.directional.color[1], lighting.directional.color[2]);
-        psxShader->setFloat("directionalIntensity", lighting.directional.intensity);
+        copy3(fc.ambientColor, lighting.ambient.color);
+        fc.ambientIntensity = lighting.ambient.intensity;
         
-        // Ambient light uniforms
-        psxShader->setVec3("ambientColor", lighting.ambient.color[0], lighting.ambient.color[1], lighting.ambient.color[2]);
-        psxShader->setFloat("ambientIntensity", lighting.ambient.intensity);
+        fc.renderSize[0] = (float)renderWidth;
+        fc.renderSize[1] = (float)renderHeight;
         
-        float view[16];
-        camera.GetViewMatrix(view);
-        psxShader->setMat4("view", view);
+        frameConstants.Upload();
         
-        float projection[16];
-        perspective(camera.Fov, currentAspectRatio, 0.1f, 100.0f, projection);
-        psxShader->setMat4("projection", projection);
+        frustum.Build(fc.view, fc.projection);
+        frustum.SetDistanceCutoff(camera.Position, cullBeyondFog ? fog.end : 0.0f);
     }
     
-    void RenderObject(const RenderObject& obj) {
-        psxShader->setBool("useTexture", obj.useTexture);
+    // Draws a sorted queue. Every instance is streamed in one upload, then each run of
+    // consecutive items sharing pass, mesh, LOD and texture binding becomes one instanced draw.
+    // All meshes share the MeshArena VAO, so a mesh change costs no bind, only a new base
+    // vertex; packed textures on one array page differ only in their instances' layers.
+    void ExecuteQueue(const RenderQueue& queue) {
+        size_t count = queue.Size();
+        if (count == 0) return;
         
-        if (obj.useTexture && obj.texture) {
-            obj.texture->Bind(0);
-            psxShader->setInt("ourTexture", 0);
+        const size_t stride = MeshArena::INSTANCE_FLOATS;
+        instanceScratch.resize(count * stride);
+        for (size_t i = 0; i < count; i++) {
+            const RenderItem& item = queue.ItemAt(i);
+            writeInstance(&instanceScratch[i * stride], item.matrix, item.texture);
         }
+        uploadInstances(instanceScratch.data(), instanceScratch.size() * sizeof(float));
         
-        float modelMatrix[16];
-        obj.transform.GetMatrix(modelMatrix);
-        psxShader->setMat4("model", modelMatrix);
+        SetOpaqueState();
+        RenderPass currentPass = RenderPass::Opaque;
         
-        if (obj.model) {
-            obj.model->Draw();
+        size_t runStart = 0;
+        while (runStart < count) {
+            const RenderItem& first = queue.ItemAt(runStart);
+            size_t runEnd = runStart + 1;
+            while (runEnd < count) {
+                const RenderItem& next = queue.ItemAt(runEnd);
+                if (next.pass != first.pass || next.model != first.model || next.lod != first.lod ||
+                    next.textureBinding != first.textureBinding) break;
+                runEnd++;
+            }
+            
+            if (first.pass != currentPass) {
+                currentPass = first.pass;
+                if (currentPass == RenderPass::Transparent) SetTransparentState();
+                else SetOpaqueState();
+            }
+            
+            int instances = (int)(runEnd - runStart);
+            bindMaterial(first.texture);
+            bindMesh(first.model);
+            MeshArena::Instance().SetInstanceBuffer(instanceVBO, runStart * stride * sizeof(float));
+            first.model->DrawInstanced(instances, first.lod);
+            countDraw(first.model->LodTriangles(first.lod), instances);
+            stats.lodObjects[first.lod] += instances;
+            
+            runStart = runEnd;
         }
     }
     
     void EndFrame(Camera& camera, int screenWidth, int screenHeight) {
-        float view[16], projection[16];
-        camera.GetViewMatrix(view);
-        perspective(camera.Fov, currentAspectRatio, 0.1f, 100.0f, projection);
-        
-        particles->Render(view, projection, camera.Position);
+        ProfileScope scope("EndFrame");
+        if (particles->Render()) {
+            countDraw(2, particles->liveCount);
+        }
         
         postProcess->EndRender();
+        frameConstants.UploadScreenSize((float)screenWidth, (float)screenHeight);
         postProcess->RenderToScreen(screenWidth, screenHeight);
     }
     
@@ -310,14 +430,77 @@ public:
         delete postProcess;
         delete shadowMap;
         delete skybox;
+        if (instanceVBO) glDeleteBuffers(1, &instanceVBO);
     }
 
 private:
-    void perspective(float fovy, float aspect, float zNear, float zFar, float* result) {
-        float f = 1.0f / tan(fovy * 3.14159265359f / 360.0f);
-        result[0] = f / aspect; result[4] = 0; result[8] = 0; result[12] = 0;
-        result[1] = 0; result[5] = f; result[9] = 0; result[13] = 0;
-        result[2] = 0; result[6] = 0; result[10] = (zFar + zNear) / (zNear - zFar); result[14] = (2 * zFar * zNear) / (zNear - zFar);
-        result[3] = 0; result[7] = 0; result[11] = -1; result[15] = 0;
+    UniformHandle<bool> useTextureUniform;
+    UniformHandle<UniformVec3> meshOffsetUniform;
+    UniformHandle<UniformVec3> meshScaleUniform;
+    UniformHandle<int> textureUniform;
+    UniformHandle<int> paletteUniform;
+    UniformHandle<int> clutBitsUniform;
+    UniformHandle<int> clutWidthUniform;
+    UniformHandle<bool> textureArrayUniform;
+    
+    unsigned int instanceVBO;
+    size_t instanceCapacity;
+    std::vector<float> instanceScratch;
+    
+    // Positions are stored quantized against each mesh's bounds
+    void bindMesh(const Model* model) {
+        const MeshQuantization& q = model->quantization;
+        psxShader->set(meshOffsetUniform, q.offset[0], q.offset[1], q.offset[2]);
+        psxShader->set(meshScaleUniform, q.scale[0], q.scale[1], q.scale[2]);
+    }
+    
+    // Matrix, then the material: array layer and image size for packed textures, else zero
+    static void writeInstance(float* out, const float* matrix, const Texture* texture) {
+        memcpy(out, matrix, 16 * sizeof(float));
+        bool packed = texture && texture->IsPacked();
+        out[16] = packed ? (float)texture->arrayLayer : 0.0f;
+        out[17] = packed ? (float)texture->width : 0.0f;
+        out[18] = packed ? (float)texture->height : 0.0f;
+        out[19] = 0.0f;
+    }
+    
+    void bindMaterial(Texture* texture) {
+        psxShader->set(useTextureUniform, texture != nullptr);
+        if (!texture) return;
+        
+        psxShader->set(clutBitsUniform, texture->clutBits);
+        psxShader->set(textureArrayUniform, texture->IsPacked());
+        if (texture->IsPacked()) {
+            GLState& state = GLState::Instance();
+            state.BindTexture(2, GL_TEXTURE_2D_ARRAY, texture->arrayPage->layers);
+            if (texture->IsPalettized()) state.BindTexture(3, GL_TEXTURE_2D, texture->arrayPage->palettes);
+            return;
+        }
+        
+        texture->Bind(0);
+        if (texture->IsPalettized()) {
+            texture->BindPalette(1);
+            psxShader->set(clutWidthUniform, texture->width);
+        }
+    }
+    
+    // Orphan the instance buffer each upload so the driver never waits on last frame's draws
+    void uploadInstances(const float* data, size_t bytes) {
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        if (bytes > instanceCapacity) {
+            instanceCapacity = bytes * 2;
+        }
+        glBufferData(GL_ARRAY_BUFFER, instanceCapacity, NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, data);
+    }
+    
+    void countDraw(size_t trianglesPerInstance, int instanceCount) {
+        stats.drawCalls++;
+        stats.instances += instanceCount;
+        stats.triangles += (long long)trianglesPerInstance * instanceCount;
+    }
+    
+    static void copy3(float* dst, const float* src) {
+        dst[0] = src[0]; dst[1] = src[1]; dst[2] = src[2];
     }
 };
\ No newline at end of file
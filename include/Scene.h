@@ -1,12 +1,20 @@
 #pragma once
 
 #include "Renderer.h"
+#include "BVH.h"
 #include <vector>
 #include <memory>
+#include <cmath>
 
 class Scene {
 public:
     std::vector<RenderObject> objects;
+    RenderQueue queue;
+    BVH bvh;
+    
+    // Culling results from the last Render call
+    int visibleCount = 0;
+    int culledCount = 0;
     
     void AddObject(Model* model, Texture* texture = nullptr) {
         RenderObject obj;
@@ -14,6 +22,7 @@ public:
         obj.texture = texture;
         obj.useTexture = (texture != nullptr);
         objects.push_back(obj);
+        NotifyObjectsChanged();
     }
     
     void AddObjectAt(Model* model, float x, float y, float z, Texture* texture = nullptr) {
@@ -25,15 +34,230 @@ public:
         obj.transform.position[1] = y;
         obj.transform.position[2] = z;
         objects.push_back(obj);
+        NotifyObjectsChanged();
+    }
+    
+    // Call after adding/removing entries in objects directly; the BVH is rebuilt on next use
+    void NotifyObjectsChanged() {
+        spatialDirty = true;
+    }
+    
+    // Call after editing an object's transform. The matrix is recomposed, together with every
+    // other transform changed this frame, and the BVH path refitted on next use.
+    void NotifyTransformChanged(int index) {
+        if (index < 0 || index >= (int)objects.size()) return;
+        objects[index].transform.MarkDirty();
+        if (!spatialDirty) changedObjects.push_back(index);
     }
     
     void Render(PSXRenderer& renderer) {
-        for (const auto& obj : objects) {
-            renderer.RenderObject(obj);
+        // Pixels per world unit at view depth 1 on the low-res target
+        float lodScale = renderer.frameConstants.data.projection[5] * 0.5f * (float)renderer.renderHeight;
+        Render(renderer, renderer.frustum, renderer.frameConstants.data.view, lodScale);
+    }
+    
+    // view orders the queue by depth. lodScale is pixels per world unit at depth 1 and drives
+    // LOD selection; 0 draws every object at full detail and leaves the stored levels alone,
+    // which is what views other than the game camera want.
+    void Render(PSXRenderer& renderer, const Frustum& frustum, const float* view, float lodScale = 0.0f) {
+        SyncSpatial();
+        CullObjects(frustum);
+        BuildQueue(view, renderer.lod, lodScale);
+        renderer.ExecuteQueue(queue);
+    }
+    
+    // Closest object whose world bounds the ray hits, or -1
+    int Raycast(const float* origin, const float* dir, float maxDistance, float& hitDistance) {
+        SyncSpatial();
+        int item = bvh.Raycast(origin, dir, maxDistance, hitDistance);
+        return item >= 0 ? itemToObject[item] : -1;
+    }
+    
+    // Objects whose world bounds overlap box
+    void QueryOverlap(const AABB& box, std::vector<int>& out) {
+        SyncSpatial();
+        size_t first = out.size();
+        bvh.QueryOverlap(box, out);
+        for (size_t i = first; i < out.size(); i++) out[i] = itemToObject[out[i]];
+    }
+    
+    // Coarse culling through the BVH; only objects in leaves that straddle a plane
+    // get the per-object SIMD sphere test.
+    void CullObjects(const Frustum& frustum) {
+        insideItems.clear();
+        partialItems.clear();
+        bvh.QueryFrustum(frustum, insideItems, partialItems);
+        
+        visibleObjects.clear();
+        for (int item : insideItems) {
+            visibleObjects.push_back(itemToObject[item]);
         }
+        
+        size_t count = partialItems.size();
+        packedX.resize(count);
+        packedY.resize(count);
+        packedZ.resize(count);
+        packedRadius.resize(count);
+        packedVisible.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            int object = itemToObject[partialItems[i]];
+            packedX[i] = spheres[object * 4 + 0];
+            packedY[i] = spheres[object * 4 + 1];
+            packedZ[i] = spheres[object * 4 + 2];
+            packedRadius[i] = spheres[object * 4 + 3];
+        }
+        frustum.CullSpheres(packedX.data(), packedY.data(), packedZ.data(), packedRadius.data(),
+                            (int)count, packedVisible.data());
+        for (size_t i = 0; i < count; i++) {
+            if (packedVisible[i]) visibleObjects.push_back(itemToObject[partialItems[i]]);
+        }
+        
+        visibleCount = (int)visibleObjects.size();
+        culledCount = bvh.ItemCount() - visibleCount;
+    }
+    
+    // Submit every visible object with a key built from its state, LOD and view depth, then sort
+    void BuildQueue(const float* view, const LodSettings& lodSettings, float lodScale) {
+        queue.Clear();
+        for (int i : visibleObjects) {
+            RenderObject& obj = objects[i];
+            const float* sphere = &spheres[i * 4];
+            
+            // The camera looks down -z in view space
+            float depth = -(view[2] * sphere[0] + view[6] * sphere[1] + view[10] * sphere[2] + view[14]);
+            
+            uint8_t lod = 0;
+            if (lodScale > 0.0f) {
+                // Inside or touching the sphere counts as filling the screen
+                float pixelSize = depth > sphere[3] ? 2.0f * sphere[3] * lodScale / depth : 1e9f;
+                obj.lod = (uint8_t)lodSettings.Select(obj.lod, obj.model->LodCount(), pixelSize);
+                lod = obj.lod;
+            }
+            
+            RenderPass pass = obj.transparent ? RenderPass::Transparent : RenderPass::Opaque;
+            Texture* texture = obj.useTexture ? obj.texture : nullptr;
+            queue.Submit(pass, 0, obj.model, texture, texture ? texture->Binding() : nullptr,
+                         obj.transform.GetMatrix(), depth, lod);
+        }
+        queue.Sort();
     }
     
     void Clear() {
         objects.clear();
+        queue.Clear();
+        NotifyObjectsChanged();
+    }
+
+private:
+    // Cached world state per object, refreshed when the scene or a transform changes
+    bool spatialDirty = true;
+    size_t spatialObjectCount = 0;
+    std::vector<int> changedObjects;    // transforms edited since the last sync
+    std::vector<float> spheres;         // x, y, z, radius per object
+    std::vector<AABB> itemBounds;       // per BVH item
+    std::vector<int> objectToItem;      // -1 for objects without a model
+    std::vector<int> itemToObject;
+    
+    std::vector<int> insideItems, partialItems, visibleObjects;
+    std::vector<float> packedX, packedY, packedZ, packedRadius;
+    std::vector<unsigned char> packedVisible;
+    
+    // Scratch for composeDirtyTransforms; static objects are composed once and never again
+    std::vector<int> allObjects, dirtyScratch;
+    std::vector<float> composeInput;    // SoA TRS, 9 arrays of dirtyScratch.size()
+    std::vector<float> composeOutput;
+    
+    void SyncSpatial() {
+        if (!spatialDirty && spatialObjectCount == objects.size()) {
+            if (changedObjects.empty()) return;
+            
+            composeDirtyTransforms(changedObjects);
+            for (int index : changedObjects) {
+                updateObjectBounds(index);
+                if (objectToItem[index] >= 0) {
+                    bvh.Refit(objectToItem[index], itemBounds[objectToItem[index]]);
+                }
+            }
+            changedObjects.clear();
+            return;
+        }
+        
+        size_t count = objects.size();
+        changedObjects.clear();
+        allObjects.resize(count);
+        for (size_t i = 0; i < count; i++) allObjects[i] = (int)i;
+        composeDirtyTransforms(allObjects);
+        
+        spheres.resize(count * 4);
+        objectToItem.assign(count, -1);
+        itemToObject.clear();
+        itemBounds.clear();
+        
+        for (size_t i = 0; i < count; i++) {
+            if (!objects[i].model) continue;
+            objectToItem[i] = (int)itemToObject.size();
+            itemToObject.push_back((int)i);
+            itemBounds.push_back(AABB());
+        }
+        for (size_t i = 0; i < count; i++) {
+            updateObjectBounds((int)i);
+        }
+        
+        bvh.Build(itemBounds);
+        spatialDirty = false;
+        spatialObjectCount = count;
+    }
+    
+    // Recompose the dirty transforms among indices in one ComposeTransforms call
+    void composeDirtyTransforms(const std::vector<int>& indices) {
+        dirtyScratch.clear();
+        for (int index : indices) {
+            if (objects[index].transform.IsDirty()) dirtyScratch.push_back(index);
+        }
+        size_t count = dirtyScratch.size();
+        if (count == 0) return;
+        
+        composeInput.resize(count * 9);
+        float* soa[9];
+        for (int a = 0; a < 9; a++) soa[a] = &composeInput[a * count];
+        for (size_t i = 0; i < count; i++) {
+            const Transform& t = objects[dirtyScratch[i]].transform;
+            for (int c = 0; c < 3; c++) {
+                soa[0 + c][i] = t.position[c];
+                soa[3 + c][i] = t.rotation[c];
+                soa[6 + c][i] = t.scale[c];
+            }
+        }
+        
+        TransformBatch batch = {soa[0], soa[1], soa[2], soa[3], soa[4], soa[5], soa[6], soa[7], soa[8]};
+        composeOutput.resize(count * 16);
+        ComposeTransforms(batch, (int)count, composeOutput.data());
+        
+        for (size_t i = 0; i < count; i++) {
+            objects[dirtyScratch[i]].transform.SetMatrix(&composeOutput[i * 16]);
+        }
+    }
+    
+    void updateObjectBounds(int index) {
+        const RenderObject& obj = objects[index];
+        const float* m = obj.transform.GetMatrix();
+        
+        int item = objectToItem[index];
+        if (item < 0) return;
+        
+        const Model* model = obj.model;
+        const float* c = model->boundsCenter;
+        float* sphere = &spheres[index * 4];
+        sphere[0] = m[0] * c[0] + m[4] * c[1] + m[8] * c[2] + m[12];
+        sphere[1] = m[1] * c[0] + m[5] * c[1] + m[9] * c[2] + m[13];
+        sphere[2] = m[2] * c[0] + m[6] * c[1] + m[10] * c[2] + m[14];
+        
+        float sx = m[0] * m[0] + m[1] * m[1] + m[2] * m[2];
+        float sy = m[4] * m[4] + m[5] * m[5] + m[6] * m[6];
+        float sz = m[8] * m[8] + m[9] * m[9] + m[10] * m[10];
+        float maxScaleSq = sx > sy ? (sx > sz ? sx : sz) : (sy > sz ? sy : sz);
+        sphere[3] = model->boundsRadius * sqrt(maxScaleSq);
+        
+        itemBounds[item] = TransformAABB(model->boundsMin, model->boundsMax, m);
     }
 };
\ No newline at end of file
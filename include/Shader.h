@@ -5,6 +5,24 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
+#include <unordered_map>
+#include <cstring>
+#include "FrameConstants.h"
+#include "ProgramCache.h"
+#include "GLState.h"
+
+// Tag types for uniforms that don't map onto a single C++ scalar
+struct UniformVec3 {};
+struct UniformMat4 {};
+
+// Resolved uniform, obtained once through Shader::getUniform<T>() and reused every frame
+template <typename T>
+struct UniformHandle {
+    int slot = -1;
+
+    bool IsValid() const { return slot >= 0; }
+};
 
 class Shader {
 public:
@@ -31,48 +49,103 @@ public:
             vShaderFile.close();
             fShaderFile.close();
 
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();
+            vertexCode = ExpandFrameConstants(vShaderStream.str());
+            fragmentCode = ExpandFrameConstants(fShaderStream.str());
         }
         catch (std::ifstream::failure& e) {
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
         }
 
-        const char* vShaderCode = vertexCode.c_str();
-        const char* fShaderCode = fragmentCode.c_str();
+        build(vertexCode, fragmentCode);
+    }
 
-        // Compile shaders
-        unsigned int vertex, fragment;
+    // Constructor from string sources (for embedded shaders)
+    Shader(const std::string& vertexSource, const std::string& fragmentSource, bool fromString) {
+        build(vertexSource, fragmentSource);
+    }
 
-        // Vertex shader
-        vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderCode, NULL);
-        glCompileShader(vertex);
-        checkCompileErrors(vertex, "VERTEX");
+    void use() {
+        GLState::Instance().UseProgram(ID);
+    }
 
-        // Fragment shader
-        fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderCode, NULL);
-        glCompileShader(fragment);
-        checkCompileErrors(fragment, "FRAGMENT");
+    template <typename T>
+    UniformHandle<T> getUniform(const std::string& name) const {
+        UniformHandle<T> handle;
+        handle.slot = findSlot(name);
+        return handle;
+    }
 
-        // Shader program
-        ID = glCreateProgram();
-        glAttachShader(ID, vertex);
-        glAttachShader(ID, fragment);
-        glLinkProgram(ID);
-        checkCompileErrors(ID, "PROGRAM");
+    void set(UniformHandle<bool> handle, bool value) const {
+        setSlot1i(handle.slot, (int)value);
+    }
 
-        // Delete shaders as they're linked into our program now and no longer necessary
-        glDeleteShader(vertex);
-        glDeleteShader(fragment);
+    void set(UniformHandle<int> handle, int value) const {
+        setSlot1i(handle.slot, value);
     }
 
-    // Constructor from string sources (for embedded shaders)
-    Shader(const std::string& vertexSource, const std::string& fragmentSource, bool fromString) {
-        const char* vShaderCode = vertexSource.c_str();
-        const char* fShaderCode = fragmentSource.c_str();
+    void set(UniformHandle<float> handle, float value) const {
+        setSlot1f(handle.slot, value);
+    }
+
+    void set(UniformHandle<UniformVec3> handle, float x, float y, float z) const {
+        setSlot3f(handle.slot, x, y, z);
+    }
+
+    void set(UniformHandle<UniformMat4> handle, const float* value) const {
+        setSlotMat4(handle.slot, value);
+    }
+
+    void setBool(const std::string& name, bool value) const {
+        setSlot1i(findSlot(name), (int)value);
+    }
 
+    void setInt(const std::string& name, int value) const {
+        setSlot1i(findSlot(name), value);
+    }
+
+    void setFloat(const std::string& name, float value) const {
+        setSlot1f(findSlot(name), value);
+    }
+
+    void setVec3(const std::string& name, float x, float y, float z) const {
+        setSlot3f(findSlot(name), x, y, z);
+    }
+
+    void setMat4(const std::string& name, const float* value) const {
+        setSlotMat4(findSlot(name), value);
+    }
+
+private:
+    // Location plus a shadow copy of the last value sent, so unchanged uploads never reach the driver
+    struct UniformSlot {
+        int location;
+        bool hasValue = false;
+        float value[16];
+    };
+
+    mutable std::vector<UniformSlot> uniformSlots;
+    std::unordered_map<std::string, int> uniformLookup;
+
+    // Link from the program binary cache when possible, otherwise compile and save the result
+    void build(const std::string& vertexSource, const std::string& fragmentSource) {
+        ProgramCache& cache = ProgramCache::Instance();
+        uint64_t cacheKey = cache.Key(vertexSource, fragmentSource);
+
+        ID = glCreateProgram();
+        if (!cache.Load(ID, cacheKey)) {
+            compile(vertexSource.c_str(), fragmentSource.c_str());
+
+            int success = 0;
+            glGetProgramiv(ID, GL_LINK_STATUS, &success);
+            if (success) cache.Store(ID, cacheKey);
+        }
+
+        // Block bindings and uniform values are not part of the saved binary
+        bindUniformBlocks();
+        cacheUniforms();
+    }
+
+    void compile(const char* vShaderCode, const char* fShaderCode) {
         // Compile shaders
         unsigned int vertex, fragment;
 
@@ -89,42 +162,101 @@ public:
         checkCompileErrors(fragment, "FRAGMENT");
 
         // Shader program
-        ID = glCreateProgram();
         glAttachShader(ID, vertex);
         glAttachShader(ID, fragment);
+        ProgramCache::Instance().PrepareLink(ID);
         glLinkProgram(ID);
         checkCompileErrors(ID, "PROGRAM");
 
-        // Delete shaders
+        // Delete shaders as they're linked into our program now and no longer necessary
+        glDetachShader(ID, vertex);
+        glDetachShader(ID, fragment);
         glDeleteShader(vertex);
         glDeleteShader(fragment);
     }
 
-    void use() {
-        glUseProgram(ID);
+    // Programs that declare the per-frame block read it from the shared binding point
+    void bindUniformBlocks() {
+        unsigned int blockIndex = glGetUniformBlockIndex(ID, "FrameConstants");
+        if (blockIndex != GL_INVALID_INDEX) {
+            glUniformBlockBinding(ID, blockIndex, FRAME_CONSTANTS_BINDING);
+        }
     }
 
-    void setBool(const std::string& name, bool value) const {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+    // Enumerate the active uniforms once after linking instead of querying the driver on every set
+    void cacheUniforms() {
+        uniformSlots.clear();
+        uniformLookup.clear();
+
+        int count = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+
+        char name[256];
+        for (int i = 0; i < count; i++) {
+            int length = 0, size = 0;
+            GLenum type;
+            glGetActiveUniform(ID, (GLuint)i, sizeof(name), &length, &size, &type, name);
+
+            // Members of uniform blocks have no location
+            int location = glGetUniformLocation(ID, name);
+            if (location < 0) continue;
+
+            UniformSlot slot;
+            slot.location = location;
+            uniformLookup[std::string(name, length)] = (int)uniformSlots.size();
+
+            // Arrays are reported as "name[0]"; make them reachable by their base name too
+            if (length > 3 && strcmp(name + length - 3, "[0]") == 0) {
+                uniformLookup[std::string(name, length - 3)] = (int)uniformSlots.size();
+            }
+
+            uniformSlots.push_back(slot);
+        }
     }
 
-    void setInt(const std::string& name, int value) const {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+    int findSlot(const std::string& name) const {
+        auto it = uniformLookup.find(name);
+        return it != uniformLookup.end() ? it->second : -1;
     }
 
-    void setFloat(const std::string& name, float value) const {
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+    void setSlot1i(int index, int value) const {
+        if (index < 0) return;
+        UniformSlot& slot = uniformSlots[index];
+        float bits;
+        memcpy(&bits, &value, sizeof(bits));
+        if (slot.hasValue && memcmp(slot.value, &bits, sizeof(bits)) == 0) return;
+        slot.value[0] = bits;
+        slot.hasValue = true;
+        glUniform1i(slot.location, value);
     }
 
-    void setVec3(const std::string& name, float x, float y, float z) const {
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+    void setSlot1f(int index, float value) const {
+        if (index < 0) return;
+        UniformSlot& slot = uniformSlots[index];
+        if (slot.hasValue && slot.value[0] == value) return;
+        slot.value[0] = value;
+        slot.hasValue = true;
+        glUniform1f(slot.location, value);
     }
 
-    void setMat4(const std::string& name, const float* value) const {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, value);
+    void setSlot3f(int index, float x, float y, float z) const {
+        if (index < 0) return;
+        UniformSlot& slot = uniformSlots[index];
+        if (slot.hasValue && slot.value[0] == x && slot.value[1] == y && slot.value[2] == z) return;
+        slot.value[0] = x; slot.value[1] = y; slot.value[2] = z;
+        slot.hasValue = true;
+        glUniform3f(slot.location, x, y, z);
+    }
+
+    void setSlotMat4(int index, const float* value) const {
+        if (index < 0) return;
+        UniformSlot& slot = uniformSlots[index];
+        if (slot.hasValue && memcmp(slot.value, value, 16 * sizeof(float)) == 0) return;
+        memcpy(slot.value, value, 16 * sizeof(float));
+        slot.hasValue = true;
+        glUniformMatrix4fv(slot.location, 1, GL_FALSE, value);
     }
 
-private:
     void checkCompileErrors(unsigned int shader, std::string type) {
         int success;
         char infoLog[1024];
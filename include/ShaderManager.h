@@ -78,7 +78,7 @@ private:
             file.open(path);
             stream << file.rdbuf();
             file.close();
-            return stream.str();
+            return ExpandFrameConstants(stream.str());
         }
         catch (std::ifstream::failure& e) {
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << path << std::endl;
@@ -3,7 +3,8 @@
 #include <glad/glad.h>
 #include "Shader.h"
 #include "Camera.h"
-#include <GLFW/glfw3.h>
+#include "Profiler.h"
+#include "GLState.h"
 #include <iostream>
 #include <cstdlib>
 #include <cmath>
@@ -26,35 +27,26 @@ public:
         totalTime += deltaTime;
     }
     
-    void Render(Camera& camera, float aspectRatio) {
+    // View and projection come from the FrameConstants block filled by PSXRenderer
+    void Render() {
         if (!skyboxShader) return;
+        ProfileScope scope("Skybox");
         
-        glDepthFunc(GL_LEQUAL);
-        glDepthMask(GL_FALSE);
+        // Drawn at the far plane behind everything, without writing depth
+        GLState& state = GLState::Instance();
+        state.SetBlend(false);
+        state.SetDepthTest(true);
+        state.DepthFunc(GL_LEQUAL);
+        state.DepthMask(false);
         
         skyboxShader->use();
         
-        float view[16];
-        camera.GetViewMatrix(view);
-        view[12] = view[13] = view[14] = 0.0f;
-        
-        float projection[16];
-        perspective(camera.Fov, aspectRatio, 0.1f, 100.0f, projection);
-        
-        skyboxShader->setMat4("view", view);
-        skyboxShader->setMat4("projection", projection);
-        skyboxShader->setFloat("time", totalTime);
-        
-        glBindVertexArray(skyboxVAO);
+        state.BindVertexArray(skyboxVAO);
         glDrawArrays(GL_TRIANGLES, 0, 36);
-        glBindVertexArray(0);
-        
-        glDepthFunc(GL_LESS);
-        glDepthMask(GL_TRUE);
     }
     
     ~Skybox() {
-        if (skyboxVAO) glDeleteVertexArrays(1, &skyboxVAO);
+        if (skyboxVAO) GLState::Instance().DeleteVertexArray(skyboxVAO);
         if (skyboxVBO) glDeleteBuffers(1, &skyboxVBO);
         delete skyboxShader;
     }
@@ -78,7 +70,7 @@ private:
 
         glGenVertexArrays(1, &skyboxVAO);
         glGenBuffers(1, &skyboxVBO);
-        glBindVertexArray(skyboxVAO);
+        GLState::Instance().BindVertexArray(skyboxVAO);
         glBindBuffer(GL_ARRAY_BUFFER, skyboxVBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), skyboxVertices, GL_STATIC_DRAW);
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
@@ -86,24 +78,22 @@ private:
     }
     
     void createSkyboxShader() {
-        std::string vertexSource = R"(
-            #version 330 core
+        std::string vertexSource = std::string(R"(
+            #version 330 core)") + FRAME_CONSTANTS_GLSL + R"(
             layout (location = 0) in vec3 aPos;
             out vec3 WorldPos;
-            uniform mat4 projection;
-            uniform mat4 view;
             void main() {
                 WorldPos = aPos;
-                vec4 pos = projection * view * vec4(aPos, 1.0);
+                // Drop the translation so the sky stays centred on the camera
+                vec4 pos = projection * mat4(mat3(view)) * vec4(aPos, 1.0);
                 gl_Position = pos.xyww;
             }
         )";
         
-        std::string fragmentSource = R"(
-            #version 330 core
+        std::string fragmentSource = std::string(R"(
+            #version 330 core)") + FRAME_CONSTANTS_GLSL + R"(
             in vec3 WorldPos;
             out vec4 FragColor;
-            uniform float time;
             
             float hash(float n) {
                 return fract(sin(n) * 43758.5453);
@@ -186,12 +176,4 @@ private:
         
         skyboxShader = new Shader(vertexSource, fragmentSource, true);
     }
-    
-    void perspective(float fovy, float aspect, float zNear, float zFar, float* result) {
-        float f = 1.0f / tan(fovy * 3.14159265359f / 360.0f);
-        result[0] = f / aspect; result[4] = 0; result[8] = 0; result[12] = 0;
-        result[1] = 0; result[5] = f; result[9] = 0; result[13] = 0;
-        result[2] = 0; result[6] = 0; result[10] = (zFar + zNear) / (zNear - zFar); result[14] = (2 * zFar * zNear) / (zNear - zFar);
-        result[3] = 0; result[7] = 0; result[11] = -1; result[15] = 0;
-    }
 };
\ No newline at end of file
@@ -1,8 +1,12 @@
 #pragma once
 
 #include <glad/glad.h>
+#include "GLState.h"
+#include "ColorQuantizer.h"
+#include "TextureArray.h"
 #include <iostream>
 #include <string>
+#include <vector>
 
 // Forward declaration - we'll implement stb_image in a separate file
 // Don't define STB_IMAGE_IMPLEMENTATION here
@@ -11,54 +15,222 @@
 class Texture {
 public:
     unsigned int ID;
+    unsigned int paletteID; // CLUT textures only: 1 << clutBits RGBA8 entries in one row
     int width, height, channels;
+    unsigned char* pixels; // decoded image waiting for Upload()
 
-    Texture() : ID(0), width(0), height(0), channels(0) {}
+    // 0 uploads direct colour. 4 or 8 quantizes to a 16 or 256 entry palette at load time and
+    // uploads one R8 index texture (two 4-bit indices per byte at 4bpp, low nibble is the even
+    // column); the psx shader resolves the palette. Set before loading.
+    int clutBits;
+
+    // FNV-1a of the decoded image and its load settings, set by LoadPixels; equal hashes
+    // mean identical GPU contents, which TextureCache uses to share one copy
+    uint64_t contentHash;
+
+    // Upload into a shared TextureArrayPool layer instead of a texture of its own when the
+    // image is small enough; clear before uploading for a standalone GL texture
+    bool packInArray;
+    TextureArrayPage* arrayPage; // set when packed, with ID left 0
+    int arrayLayer;
+
+    Texture() : ID(0), paletteID(0), width(0), height(0), channels(0), pixels(nullptr), clutBits(0), contentHash(0),
+                packInArray(true), arrayPage(nullptr), arrayLayer(-1) {}
+
+    // Owns GL names, so a copy would delete them twice
+    Texture(const Texture&) = delete;
+    Texture& operator=(const Texture&) = delete;
+
+    bool IsPalettized() const { return clutBits != 0; }
+    bool IsPacked() const { return arrayPage != nullptr; }
+    bool IsUploaded() const { return ID != 0 || arrayPage != nullptr; }
+
+    // What a draw binds for this texture; packed textures on one page share it and can batch
+    const void* Binding() const { return arrayPage ? (const void*)arrayPage : (const void*)this; }
+
+    // Width of the index texture in texels
+    int IndexWidth() const { return clutBits == 4 ? (width + 1) / 2 : width; }
 
     bool LoadFromFile(const std::string& path) {
+        if (!LoadPixels(path)) {
+            return false;
+        }
+        Upload();
+        return true;
+    }
+
+    // Decode the image into memory; no GL calls, so this can run on a worker thread
+    bool LoadPixels(const std::string& path) {
+        stbi_set_flip_vertically_on_load_thread(true);
+        pixels = stbi_load(path.c_str(), &width, &height, &channels, 0);
+
+        if (!pixels) {
+            std::cout << "Failed to load texture: " << path << std::endl;
+            return false;
+        }
+
+        if (clutBits != 0 && clutBits != 4 && clutBits != 8) {
+            std::cout << "Unsupported CLUT depth " << clutBits << " for " << path << ", using direct colour" << std::endl;
+            clutBits = 0;
+        }
+        contentHash = hashContent();
+        if (clutBits) {
+            int colors = quantize();
+            std::cout << "Texture loaded: " << path << " (" << width << "x" << height << ", "
+                      << clutBits << "bpp CLUT, " << colors << " colours)" << std::endl;
+            return true;
+        }
+
+        std::cout << "Texture loaded: " << path << " (" << width << "x" << height << ")" << std::endl;
+        return true;
+    }
+
+    // Create the GL texture (or array layer) from the decoded pixels and release them; main thread only
+    void Upload() {
+        if (packInArray && uploadToArray()) return;
+
         glGenTextures(1, &ID);
-        glBindTexture(GL_TEXTURE_2D, ID);
+        GLState::Instance().BindTexture(0, GL_TEXTURE_2D, ID);
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
-        stbi_set_flip_vertically_on_load(true);
-        unsigned char* data = stbi_load(path.c_str(), &width, &height, &channels, 0);
-        
-        if (data) {
-            GLenum format;
-            if (channels == 1) format = GL_RED;
-            else if (channels == 3) format = GL_RGB;
-            else if (channels == 4) format = GL_RGBA;
-            else format = GL_RGB;
-
-            glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-            glGenerateMipmap(GL_TEXTURE_2D);
-            
-            stbi_image_free(data);
-            std::cout << "Texture loaded: " << path << " (" << width << "x" << height << ")" << std::endl;
-            return true;
-        } else {
-            std::cout << "Failed to load texture: " << path << std::endl;
-            stbi_image_free(data);
-            return false;
+        // Point sampled without mips: a mip chain would never be read
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+
+        if (clutBits) {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, IndexWidth(), height, 0, GL_RED, GL_UNSIGNED_BYTE, clutIndices.data());
+            uploadPalette();
+            std::vector<uint8_t>().swap(clutIndices);
+            std::vector<uint8_t>().swap(clutPalette);
+            return;
         }
+
+        GLenum format;
+        if (channels == 1) format = GL_RED;
+        else if (channels == 3) format = GL_RGB;
+        else if (channels == 4) format = GL_RGBA;
+        else format = GL_RGB;
+
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, pixels);
+
+        stbi_image_free(pixels);
+        pixels = nullptr;
     }
 
     void Bind(unsigned int slot = 0) {
-        glActiveTexture(GL_TEXTURE0 + slot);
-        glBindTexture(GL_TEXTURE_2D, ID);
+        GLState::Instance().BindTexture(slot, GL_TEXTURE_2D, ID);
+    }
+
+    void BindPalette(unsigned int slot) {
+        GLState::Instance().BindTexture(slot, GL_TEXTURE_2D, paletteID);
+    }
+
+    void Unbind(unsigned int slot = 0) {
+        GLState::Instance().BindTexture(slot, GL_TEXTURE_2D, 0);
     }
 
-    void Unbind() {
-        glBindTexture(GL_TEXTURE_2D, 0);
+    // Video memory held by the index (or colour) texture and the palette
+    size_t GpuBytes() const {
+        if (arrayPage) return arrayPage->LayerBytes();
+        if (!ID) return 0;
+        if (clutBits) return (size_t)IndexWidth() * height + ((size_t)4 << clutBits);
+        int texelBytes = channels == 1 ? 1 : 4; // drivers pad RGB8 to 4 bytes
+        return (size_t)width * height * texelBytes;
     }
 
     ~Texture() {
+        if (pixels) {
+            stbi_image_free(pixels);
+        }
         if (ID != 0) {
-            glDeleteTextures(1, &ID);
+            GLState::Instance().DeleteTexture(ID);
+        }
+        if (paletteID != 0) {
+            GLState::Instance().DeleteTexture(paletteID);
+        }
+        if (arrayPage) {
+            TextureArrayPool::Instance().Free(arrayPage, arrayLayer);
         }
     }
-};
\ No newline at end of file
+
+private:
+    uint64_t hashContent() const {
+        uint64_t hash = 14695981039346656037ull;
+        auto mix = [&hash](const unsigned char* bytes, size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                hash ^= bytes[i];
+                hash *= 1099511628211ull;
+            }
+        };
+        int settings[4] = {width, height, channels, clutBits};
+        mix((const unsigned char*)settings, sizeof(settings));
+        mix(pixels, (size_t)width * height * channels);
+        return hash;
+    }
+
+    std::vector<uint8_t> clutIndices; // IndexWidth() x height, waiting for Upload()
+    std::vector<uint8_t> clutPalette; // 1 << clutBits RGBA8 entries
+
+    // Median-cut the decoded pixels into clutIndices/clutPalette and free them
+    int quantize() {
+        int pixelCount = width * height;
+        std::vector<uint8_t> rgba, indices;
+        ExpandToRGBA(pixels, pixelCount, channels, rgba);
+        stbi_image_free(pixels);
+        pixels = nullptr;
+
+        int colors = QuantizeMedianCut(rgba.data(), pixelCount, 1 << clutBits, indices, clutPalette);
+        clutPalette.resize((size_t)4 << clutBits, 0);
+
+        if (clutBits == 8) {
+            clutIndices.swap(indices);
+            return colors;
+        }
+
+        int indexWidth = IndexWidth();
+        clutIndices.assign((size_t)indexWidth * height, 0);
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                uint8_t index = indices[(size_t)y * width + x];
+                clutIndices[(size_t)y * indexWidth + x / 2] |= (x & 1) ? (uint8_t)(index << 4) : index;
+            }
+        }
+        return colors;
+    }
+
+    // Grey and grey-alpha images keep their own GL_RED texture; colour pages are RGBA8
+    bool uploadToArray() {
+        if (!clutBits && channels < 3) return false;
+
+        TextureArrayPool& pool = TextureArrayPool::Instance();
+        arrayPage = pool.Allocate(clutBits, IndexWidth(), height, arrayLayer);
+        if (!arrayPage) return false;
+
+        if (clutBits) {
+            clutPalette.resize(TextureArrayPool::PALETTE_ENTRIES * 4, 0);
+            pool.UploadLayer(arrayPage, arrayLayer, IndexWidth(), height, GL_RED, clutIndices.data(), clutPalette.data());
+            std::vector<uint8_t>().swap(clutIndices);
+            std::vector<uint8_t>().swap(clutPalette);
+            return true;
+        }
+
+        pool.UploadLayer(arrayPage, arrayLayer, width, height, channels == 4 ? GL_RGBA : GL_RGB, pixels, nullptr);
+        stbi_image_free(pixels);
+        pixels = nullptr;
+        return true;
+    }
+
+    void uploadPalette() {
+        glGenTextures(1, &paletteID);
+        GLState::Instance().BindTexture(0, GL_TEXTURE_2D, paletteID);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1 << clutBits, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, clutPalette.data());
+    }
+};
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "GLState.h"
+
+// A GL_TEXTURE_2D_ARRAY whose layers all share one storage format and one padded size.
+// CLUT pages hold R8 indices and keep each layer's palette as one row of a second texture.
+struct TextureArrayPage {
+    unsigned int layers = 0;   // GL_TEXTURE_2D_ARRAY
+    unsigned int palettes = 0; // CLUT pages: one 256-entry RGBA8 row per layer
+    int clutBits = 0;          // 0 = RGBA8 colour, 4 or 8 = R8 indices
+    int width = 0;             // layer size in stored texels (4bpp stores two indices per texel)
+    int height = 0;
+    std::vector<int> freeLayers;
+
+    size_t LayerBytes() const {
+        return clutBits ? (size_t)width * height + 256 * 4 : (size_t)width * height * 4;
+    }
+};
+
+// Packs small textures into array pages at upload time so objects with different textures
+// can share one instanced draw: a draw binds the page, and each instance carries its layer.
+// Layers are padded up to power-of-two sizes, one page per format and size class, and pages
+// are fixed at LAYERS_PER_PAGE so they never need reallocating. Main thread only.
+class TextureArrayPool {
+public:
+    static const int LAYERS_PER_PAGE = 64;
+    static const int MAX_LAYER_SIZE = 256;
+    static const int PALETTE_ENTRIES = 256;
+
+    static TextureArrayPool& Instance() {
+        static TextureArrayPool instance;
+        return instance;
+    }
+
+    static int PaddedSize(int size) {
+        int padded = 1;
+        while (padded < size) padded *= 2;
+        return padded;
+    }
+
+    // A free layer for a width x height image in stored texels, or nullptr when it is too
+    // large to pack
+    TextureArrayPage* Allocate(int clutBits, int width, int height, int& layer) {
+        int paddedWidth = PaddedSize(width);
+        int paddedHeight = PaddedSize(height);
+        if (paddedWidth > MAX_LAYER_SIZE || paddedHeight > MAX_LAYER_SIZE) return nullptr;
+
+        for (auto& page : pages) {
+            if (page->clutBits != clutBits || page->width != paddedWidth || page->height != paddedHeight) continue;
+            if (page->freeLayers.empty()) continue;
+            layer = page->freeLayers.back();
+            page->freeLayers.pop_back();
+            layersUsed++;
+            return page.get();
+        }
+
+        TextureArrayPage* page = createPage(clutBits, paddedWidth, paddedHeight);
+        layer = page->freeLayers.back();
+        page->freeLayers.pop_back();
+        layersUsed++;
+        return page;
+    }
+
+    // pixels are width x height texels of format (GL_RED indices for CLUT pages); palette is
+    // PALETTE_ENTRIES RGBA8 entries for CLUT pages, ignored otherwise
+    void UploadLayer(TextureArrayPage* page, int layer, int width, int height, GLenum format,
+                     const void* pixels, const uint8_t* palette) {
+        GLState& state = GLState::Instance();
+        state.BindTexture(0, GL_TEXTURE_2D_ARRAY, page->layers);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1, format, GL_UNSIGNED_BYTE, pixels);
+        if (page->clutBits) {
+            state.BindTexture(0, GL_TEXTURE_2D, page->palettes);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, layer, PALETTE_ENTRIES, 1, GL_RGBA, GL_UNSIGNED_BYTE, palette);
+        }
+    }
+
+    // CPU bookkeeping only, so it is safe after the context is gone, but not after Shutdown
+    void Free(TextureArrayPage* page, int layer) {
+        page->freeLayers.push_back(layer);
+        layersUsed--;
+    }
+
+    // Delete every page's GL names while the context is still current. Every packed texture
+    // must already be destroyed: the pool is a function-local static, so leaving this to
+    // static destruction would free the pages before global owners release their layers
+    void Shutdown() {
+        if (layersUsed != 0) {
+            std::cout << "TextureArrayPool shut down with " << layersUsed << " layers still in use" << std::endl;
+        }
+        GLState& state = GLState::Instance();
+        for (auto& page : pages) {
+            state.DeleteTexture(page->layers);
+            if (page->palettes) state.DeleteTexture(page->palettes);
+        }
+        pages.clear();
+        layersUsed = 0;
+    }
+
+    int PageCount() const { return (int)pages.size(); }
+    int LayersUsed() const { return layersUsed; }
+
+    size_t BytesAllocated() const {
+        size_t bytes = 0;
+        for (const auto& page : pages) bytes += page->LayerBytes() * LAYERS_PER_PAGE;
+        return bytes;
+    }
+
+private:
+    std::vector<std::unique_ptr<TextureArrayPage>> pages;
+    int layersUsed = 0;
+
+    TextureArrayPool() {}
+
+    TextureArrayPage* createPage(int clutBits, int width, int height) {
+        std::unique_ptr<TextureArrayPage> page(new TextureArrayPage());
+        page->clutBits = clutBits;
+        page->width = width;
+        page->height = height;
+        for (int layer = LAYERS_PER_PAGE - 1; layer >= 0; layer--) page->freeLayers.push_back(layer);
+
+        GLState& state = GLState::Instance();
+        glGenTextures(1, &page->layers);
+        state.BindTexture(0, GL_TEXTURE_2D_ARRAY, page->layers);
+        setNearest(GL_TEXTURE_2D_ARRAY);
+        GLenum internalFormat = clutBits ? GL_R8 : GL_RGBA8;
+        GLenum format = clutBits ? GL_RED : GL_RGBA;
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, internalFormat, width, height, LAYERS_PER_PAGE, 0, format, GL_UNSIGNED_BYTE, NULL);
+
+        if (clutBits) {
+            glGenTextures(1, &page->palettes);
+            state.BindTexture(0, GL_TEXTURE_2D, page->palettes);
+            setNearest(GL_TEXTURE_2D);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, PALETTE_ENTRIES, LAYERS_PER_PAGE, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        }
+
+        pages.push_back(std::move(page));
+        return pages.back().get();
+    }
+
+    // Layers are only ever texel-fetched, which ignores filtering, but keep the texture complete
+    static void setNearest(GLenum target) {
+        glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, 0);
+    }
+};
@@ -0,0 +1,202 @@
+#pragma once
+
+#include "Texture.h"
+#include "AssetLoader.h"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+
+class TextureCache;
+
+struct TextureCacheEntry {
+    std::string key;
+    std::shared_ptr<Texture> texture; // may be shared with other entries after dedup
+    std::shared_ptr<AssetHandle> load;
+    int refCount = 0;
+    uint64_t lastUse = 0;
+};
+
+// Counted reference to a cached texture; copies share the reference and the last one
+// released makes the entry evictable. Main thread only, like the cache itself.
+class TextureRef {
+public:
+    TextureRef() {}
+    TextureRef(const TextureRef& other) : cache(other.cache), entry(other.entry) { retain(); }
+    TextureRef& operator=(const TextureRef& other) {
+        if (this != &other) {
+            TextureRef copy(other);
+            std::swap(cache, copy.cache);
+            std::swap(entry, copy.entry);
+        }
+        return *this;
+    }
+    ~TextureRef() { Release(); }
+
+    void Release();
+
+    bool IsValid() const { return entry != nullptr; }
+    bool IsReady() const;
+    bool IsDone() const;
+
+    // The GL texture once loaded, nullptr before that or if the load failed
+    Texture* Get() const;
+
+private:
+    friend class TextureCache;
+    typedef TextureCacheEntry Entry;
+
+    TextureCache* cache = nullptr;
+    Entry* entry = nullptr;
+
+    TextureRef(TextureCache* owner, Entry* target) : cache(owner), entry(target) { retain(); }
+    void retain();
+};
+
+// One GPU copy per texture. Acquire dedupes by path and load settings while a load is
+// known, and by content hash once it is decoded, so the same image under two names is
+// uploaded once. Entries nobody references stay resident for reuse until the resident
+// total exceeds budgetBytes, then the least recently used of them are freed; a budget of 0
+// frees every texture on its last release. Shut the AssetLoader down before the cache goes,
+// since queued loads point back into it.
+class TextureCache {
+public:
+    size_t budgetBytes = 64 * 1024 * 1024;
+
+    TextureCache() {}
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    // Start (or join) the load of path; clutBits as in Texture::clutBits
+    TextureRef Acquire(AssetLoader& loader, const std::string& path, int clutBits = 0) {
+        std::string key = path + "#" + std::to_string(clutBits);
+        auto it = entries.find(key);
+        if (it != entries.end()) return TextureRef(this, it->second.get());
+
+        std::unique_ptr<TextureCacheEntry> created(new TextureCacheEntry());
+        TextureCacheEntry* entry = created.get();
+        entry->key = key;
+        entries[key] = std::move(created);
+
+        std::shared_ptr<Texture> texture = makeTexture();
+        texture->clutBits = clutBits;
+        entry->texture = texture;
+        entry->load = loader.Submit(path,
+            [texture, path]() { return texture->LoadPixels(path); },
+            [this, entry, texture]() { upload(entry, texture); });
+        return TextureRef(this, entry);
+    }
+
+    // Drop the least recently released unreferenced entries until under budget
+    void Trim() {
+        if (residentBytes <= budgetBytes) return;
+
+        std::vector<TextureCacheEntry*> candidates;
+        for (auto& pair : entries) {
+            TextureCacheEntry* entry = pair.second.get();
+            // load is still unset while a synchronous Acquire runs its upload
+            if (entry->refCount == 0 && entry->load && entry->load->IsDone()) candidates.push_back(entry);
+        }
+        std::sort(candidates.begin(), candidates.end(),
+                  [](const TextureCacheEntry* a, const TextureCacheEntry* b) { return a->lastUse < b->lastUse; });
+
+        // Entries sharing a texture with a referenced one free nothing, but go all the same
+        for (TextureCacheEntry* entry : candidates) {
+            if (residentBytes <= budgetBytes) break;
+            entries.erase(entry->key);
+        }
+    }
+
+    // Drop every entry at shutdown, after AssetLoader::Shutdown so no queued upload still
+    // points at one. Outstanding TextureRefs must be released first; they would dangle
+    void Clear() {
+        for (auto& pair : entries) {
+            if (pair.second->refCount > 0) {
+                std::cout << "TextureCache cleared with " << pair.first << " still referenced" << std::endl;
+            }
+        }
+        entries.clear();
+    }
+
+    size_t ResidentBytes() const { return residentBytes; }
+    int ResidentCount() const { return residentCount; }
+    int EntryCount() const { return (int)entries.size(); }
+    int DedupedCount() const { return dedupedCount; }
+
+private:
+    friend class TextureRef;
+
+    // Declared before entries: texture deleters touch these while entries is destroyed
+    std::unordered_map<uint64_t, std::weak_ptr<Texture>> byContent; // uploaded textures
+    size_t residentBytes = 0;
+    int residentCount = 0;
+    int dedupedCount = 0;   // entries sharing another entry's upload
+    uint64_t useClock = 0;
+
+    std::unordered_map<std::string, std::unique_ptr<TextureCacheEntry>> entries; // by path#clutBits
+
+    // The deleter keeps the resident totals right however many entries shared the texture
+    std::shared_ptr<Texture> makeTexture() {
+        return std::shared_ptr<Texture>(new Texture(), [this](Texture* texture) {
+            if (texture->IsUploaded()) {
+                residentBytes -= texture->GpuBytes();
+                residentCount--;
+                auto it = byContent.find(texture->contentHash);
+                if (it != byContent.end() && it->second.expired()) byContent.erase(it);
+            }
+            delete texture;
+        });
+    }
+
+    // Runs on the main thread when the decode finished; shares an identical upload if one exists
+    void upload(TextureCacheEntry* entry, const std::shared_ptr<Texture>& texture) {
+        auto it = byContent.find(texture->contentHash);
+        std::shared_ptr<Texture> existing = it != byContent.end() ? it->second.lock() : nullptr;
+        if (existing) {
+            entry->texture = existing;
+            dedupedCount++;
+            return;
+        }
+
+        texture->Upload();
+        residentBytes += texture->GpuBytes();
+        residentCount++;
+        byContent[texture->contentHash] = texture;
+        Trim();
+    }
+
+    void release(TextureCacheEntry* entry) {
+        entry->lastUse = ++useClock;
+        if (--entry->refCount > 0) return;
+        if (entry->load->GetState() == AssetState::Failed) {
+            entries.erase(entry->key);
+            return;
+        }
+        Trim();
+    }
+};
+
+inline void TextureRef::retain() {
+    if (entry) entry->refCount++;
+}
+
+inline void TextureRef::Release() {
+    if (!entry) return;
+    cache->release(entry);
+    cache = nullptr;
+    entry = nullptr;
+}
+
+inline bool TextureRef::IsReady() const {
+    return entry && entry->load->IsReady();
+}
+
+inline bool TextureRef::IsDone() const {
+    return entry && entry->load->IsDone();
+}
+
+inline Texture* TextureRef::Get() const {
+    return IsReady() ? entry->texture.get() : nullptr;
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Records timed scopes from any thread into per-thread rings and writes the most recent
+// ones as Chrome Trace Event Format JSON (chrome://tracing, ui.perfetto.dev). Each scope is
+// one complete event ("ph":"X") carrying its begin time and duration.
+class TraceRecorder {
+public:
+    static const size_t EVENTS_PER_THREAD = 1 << 16;
+
+    struct Event {
+        const char* name; // string literal, never freed
+        uint64_t beginUs;
+        uint64_t durationUs;
+    };
+
+    bool enabled = true;
+
+    static TraceRecorder& Instance() {
+        static TraceRecorder instance;
+        return instance;
+    }
+
+    static uint64_t NowUs() {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Names the calling thread in the trace; call once per thread before it records
+    void SetThreadName(const std::string& name) {
+        ThreadBuffer* buffer = threadBuffer();
+        std::lock_guard<std::mutex> lock(registryMutex);
+        buffer->name = name;
+    }
+
+    void Record(const char* name, uint64_t beginUs, uint64_t endUs) {
+        ThreadBuffer* buffer = threadBuffer();
+        uint64_t index = buffer->written.load(std::memory_order_relaxed);
+        Event& event = buffer->events[index % EVENTS_PER_THREAD];
+        event.name = name;
+        event.beginUs = beginUs;
+        event.durationUs = endUs - beginUs;
+        buffer->written.store(index + 1, std::memory_order_release);
+    }
+
+    // Write every event that ended in the last `seconds` seconds. Threads keep recording while
+    // this runs; an event being overwritten during the copy can come out torn, which is
+    // acceptable for a debugging capture.
+    bool Flush(const std::string& path, float seconds) {
+        uint64_t now = NowUs();
+        uint64_t windowUs = (uint64_t)(seconds * 1000000.0f);
+        uint64_t cutoff = now > windowUs ? now - windowUs : 0;
+
+        FILE* file = fopen(path.c_str(), "w");
+        if (!file) {
+            std::cout << "Failed to open trace file: " << path << std::endl;
+            return false;
+        }
+
+        fprintf(file, "{\"traceEvents\":[\n");
+        bool first = true;
+        size_t eventCount = 0;
+
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (const auto& buffer : buffers) {
+            fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                    first ? "" : ",\n", buffer->id, buffer->name.c_str());
+            first = false;
+
+            uint64_t written = buffer->written.load(std::memory_order_acquire);
+            uint64_t begin = written > EVENTS_PER_THREAD ? written - EVENTS_PER_THREAD : 0;
+            for (uint64_t i = begin; i < written; i++) {
+                const Event& event = buffer->events[i % EVENTS_PER_THREAD];
+                if (event.beginUs + event.durationUs < cutoff) continue;
+                fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%llu,\"dur\":%llu}",
+                        event.name, buffer->id, (unsigned long long)event.beginUs, (unsigned long long)event.durationUs);
+                eventCount++;
+            }
+        }
+
+        fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+        bool ok = fclose(file) == 0;
+        std::cout << (ok ? "Trace written: " : "Failed to write trace: ") << path << " ("
+                  << eventCount << " events, last " << seconds << "s)" << std::endl;
+        return ok;
+    }
+
+private:
+    struct ThreadBuffer {
+        int id;
+        std::string name;
+        std::atomic<uint64_t> written{0};
+        std::vector<Event> events;
+    };
+
+    // Buffers outlive their threads so a flush can still show work from finished workers
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    std::mutex registryMutex;
+
+    TraceRecorder() {}
+
+    ThreadBuffer* threadBuffer() {
+        thread_local ThreadBuffer* buffer = nullptr;
+        if (!buffer) {
+            std::unique_ptr<ThreadBuffer> created(new ThreadBuffer());
+            created->events.resize(EVENTS_PER_THREAD);
+            std::lock_guard<std::mutex> lock(registryMutex);
+            created->id = (int)buffers.size() + 1;
+            created->name = "Thread " + std::to_string(created->id);
+            buffer = created.get();
+            buffers.push_back(std::move(created));
+        }
+        return buffer;
+    }
+};
+
+// Records the enclosing block as one trace event (name must be a string literal)
+class TraceScope {
+public:
+    explicit TraceScope(const char* name) : name(name), beginUs(0) {
+        if (TraceRecorder::Instance().enabled) beginUs = TraceRecorder::NowUs();
+    }
+
+    ~TraceScope() {
+        if (beginUs) TraceRecorder::Instance().Record(name, beginUs, TraceRecorder::NowUs());
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name;
+    uint64_t beginUs;
+};
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstring>
+#include "PsxMath.h"
+
+// Translation, Euler rotation (radians) and scale plus the composed world matrix
+// (column-major, T * R * S). Rotation applies Z, then X, then Y: R = Ry * Rx * Rz.
+// Editors change the fields directly and then call MarkDirty(); the matrix is only
+// recomputed while dirty, either lazily here or in a batch by ComposeTransforms.
+struct Transform {
+    float position[3] = {0.0f, 0.0f, 0.0f};
+    float rotation[3] = {0.0f, 0.0f, 0.0f};
+    float scale[3] = {1.0f, 1.0f, 1.0f};
+
+    void MarkDirty() { dirty = true; }
+    bool IsDirty() const { return dirty; }
+
+    const float* GetMatrix() const {
+        if (dirty) {
+            ComposeTransform(position, rotation, scale, matrix);
+            dirty = false;
+        }
+        return matrix;
+    }
+
+    void GetMatrix(float* result) const {
+        memcpy(result, GetMatrix(), 16 * sizeof(float));
+    }
+
+    // Used by batch updates that composed the matrix elsewhere
+    void SetMatrix(const float* composed) const {
+        memcpy(matrix, composed, 16 * sizeof(float));
+        dirty = false;
+    }
+
+    // Scalar reference; ComposeTransforms must match it
+    static void ComposeTransform(const float* p, const float* r, const float* s, float* m) {
+        Mat4FromTRS(vec3(p), QuatFromEuler(r[0], r[1], r[2]), vec3(s)).Store(m);
+    }
+
+private:
+    mutable float matrix[16];
+    mutable bool dirty = true;
+};
+
+// Structure-of-arrays input for ComposeTransforms; one entry per transform in each array
+struct TransformBatch {
+    const float* px; const float* py; const float* pz;
+    const float* rx; const float* ry; const float* rz;
+    const float* sx; const float* sy; const float* sz;
+};
+
+// Compose count world matrices (16 floats each) from SoA TRS input. SSE does four
+// transforms per iteration and transposes the results out to per-object matrices.
+inline void ComposeTransforms(const TransformBatch& in, int count, float* outMatrices) {
+    int i = 0;
+#ifdef PSX_MATH_SSE
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 zero = _mm_setzero_ps();
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 sx, cx, sy, cy, sz, cz;
+        SinCos4(_mm_mul_ps(_mm_loadu_ps(in.rx + i), half), sx, cx);
+        SinCos4(_mm_mul_ps(_mm_loadu_ps(in.ry + i), half), sy, cy);
+        SinCos4(_mm_mul_ps(_mm_loadu_ps(in.rz + i), half), sz, cz);
+
+        __m128 cycx = _mm_mul_ps(cy, cx), sysx = _mm_mul_ps(sy, sx);
+        __m128 cysx = _mm_mul_ps(cy, sx), sycx = _mm_mul_ps(sy, cx);
+        __m128 qx = _mm_add_ps(_mm_mul_ps(cysx, cz), _mm_mul_ps(sycx, sz));
+        __m128 qy = _mm_sub_ps(_mm_mul_ps(sycx, cz), _mm_mul_ps(cysx, sz));
+        __m128 qz = _mm_sub_ps(_mm_mul_ps(cycx, sz), _mm_mul_ps(sysx, cz));
+        __m128 qw = _mm_add_ps(_mm_mul_ps(cycx, cz), _mm_mul_ps(sysx, sz));
+
+        __m128 xx = _mm_mul_ps(qx, qx), yy = _mm_mul_ps(qy, qy), zz = _mm_mul_ps(qz, qz);
+        __m128 xy = _mm_mul_ps(qx, qy), xz = _mm_mul_ps(qx, qz), yz = _mm_mul_ps(qy, qz);
+        __m128 wx = _mm_mul_ps(qw, qx), wy = _mm_mul_ps(qw, qy), wz = _mm_mul_ps(qw, qz);
+
+        __m128 scaleX = _mm_loadu_ps(in.sx + i);
+        __m128 scaleY = _mm_loadu_ps(in.sy + i);
+        __m128 scaleZ = _mm_loadu_ps(in.sz + i);
+
+        __m128 m[16];
+        m[0] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), scaleX);
+        m[1] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), scaleX);
+        m[2] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), scaleX);
+        m[3] = zero;
+        m[4] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), scaleY);
+        m[5] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), scaleY);
+        m[6] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), scaleY);
+        m[7] = zero;
+        m[8] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), scaleZ);
+        m[9] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), scaleZ);
+        m[10] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), scaleZ);
+        m[11] = zero;
+        m[12] = _mm_loadu_ps(in.px + i);
+        m[13] = _mm_loadu_ps(in.py + i);
+        m[14] = _mm_loadu_ps(in.pz + i);
+        m[15] = one;
+
+        // Each register holds one element for four transforms; transpose each column back out
+        float* out = outMatrices + (size_t)i * 16;
+        for (int column = 0; column < 4; column++) {
+            __m128 r0 = m[column * 4 + 0], r1 = m[column * 4 + 1];
+            __m128 r2 = m[column * 4 + 2], r3 = m[column * 4 + 3];
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            _mm_storeu_ps(out + 0 * 16 + column * 4, r0);
+            _mm_storeu_ps(out + 1 * 16 + column * 4, r1);
+            _mm_storeu_ps(out + 2 * 16 + column * 4, r2);
+            _mm_storeu_ps(out + 3 * 16 + column * 4, r3);
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        float p[3] = {in.px[i], in.py[i], in.pz[i]};
+        float r[3] = {in.rx[i], in.ry[i], in.rz[i]};
+        float s[3] = {in.sx[i], in.sy[i], in.sz[i]};
+        Transform::ComposeTransform(p, r, s, outMatrices + (size_t)i * 16);
+    }
+}
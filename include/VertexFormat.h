@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <cfloat>
+
+// Full-precision vertex produced by the importer; only lives on the CPU while a model is built
+struct Vertex {
+    float Position[3];
+    float Normal[3];
+    float Color[3];
+    float TexCoords[2];
+};
+
+// What the GPU reads: 20 bytes against 44 for the float layout above.
+//   position   int16 x3, dequantized by the mesh's MeshQuantization (w is padding so every
+//              attribute stays 4-byte aligned)
+//   normal     octahedral int16 x2
+//   color      RGBA8, normalized
+//   texCoords  int16 x2 fixed point, TEXCOORD_UNITS per 1.0, so UVs may tile up to +-32
+struct PackedVertex {
+    int16_t Position[4];
+    int16_t Normal[2];
+    uint8_t Color[4];
+    int16_t TexCoords[2];
+};
+
+static_assert(sizeof(PackedVertex) == 20, "PackedVertex layout is part of the .psxmesh format");
+
+const float TEXCOORD_UNITS = 1024.0f;
+
+// Maps the mesh's bounding box onto the int16 range: position = offset + quantized * scale
+struct MeshQuantization {
+    float offset[3] = {0.0f, 0.0f, 0.0f};
+    float scale[3] = {1.0f, 1.0f, 1.0f};
+
+    static MeshQuantization FromBounds(const float* boundsMin, const float* boundsMax) {
+        MeshQuantization result;
+        for (int axis = 0; axis < 3; axis++) {
+            float halfExtent = (boundsMax[axis] - boundsMin[axis]) * 0.5f;
+            result.offset[axis] = (boundsMin[axis] + boundsMax[axis]) * 0.5f;
+            result.scale[axis] = halfExtent > 0.0f ? halfExtent / 32767.0f : 1.0f;
+        }
+        return result;
+    }
+};
+
+inline int16_t QuantizeInt16(float value) {
+    float rounded = roundf(value);
+    if (rounded > 32767.0f) return 32767;
+    if (rounded < -32767.0f) return -32767;
+    return (int16_t)rounded;
+}
+
+inline uint8_t QuantizeUnorm8(float value) {
+    if (!(value > 0.0f)) return 0;
+    if (value >= 1.0f) return 255;
+    return (uint8_t)(value * 255.0f + 0.5f);
+}
+
+// Unit vector onto the octahedron, folded into [-1, 1]^2; the shader's decode inverts it
+inline void OctahedralEncode(const float* normal, int16_t* out) {
+    float sum = fabsf(normal[0]) + fabsf(normal[1]) + fabsf(normal[2]);
+    if (!(sum > 0.0f)) {
+        out[0] = 0;
+        out[1] = 0;
+        return;
+    }
+    float x = normal[0] / sum;
+    float y = normal[1] / sum;
+    if (normal[2] < 0.0f) {
+        float foldedX = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float foldedY = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = foldedX;
+        y = foldedY;
+    }
+    out[0] = QuantizeInt16(x * 32767.0f);
+    out[1] = QuantizeInt16(y * 32767.0f);
+}
+
+inline void OctahedralDecode(const int16_t* encoded, float* normal) {
+    float x = encoded[0] / 32767.0f;
+    float y = encoded[1] / 32767.0f;
+    float z = 1.0f - fabsf(x) - fabsf(y);
+    float t = z < 0.0f ? -z : 0.0f;
+    x += x >= 0.0f ? -t : t;
+    y += y >= 0.0f ? -t : t;
+    float length = sqrtf(x * x + y * y + z * z);
+    normal[0] = x / length;
+    normal[1] = y / length;
+    normal[2] = z / length;
+}
+
+inline PackedVertex PackVertex(const Vertex& vertex, const MeshQuantization& quantization) {
+    PackedVertex packed;
+    for (int axis = 0; axis < 3; axis++) {
+        packed.Position[axis] = QuantizeInt16((vertex.Position[axis] - quantization.offset[axis]) / quantization.scale[axis]);
+    }
+    packed.Position[3] = 0;
+    OctahedralEncode(vertex.Normal, packed.Normal);
+    for (int channel = 0; channel < 3; channel++) {
+        packed.Color[channel] = QuantizeUnorm8(vertex.Color[channel]);
+    }
+    packed.Color[3] = 255;
+    packed.TexCoords[0] = QuantizeInt16(vertex.TexCoords[0] * TEXCOORD_UNITS);
+    packed.TexCoords[1] = QuantizeInt16(vertex.TexCoords[1] * TEXCOORD_UNITS);
+    return packed;
+}
+
+// GLSL for the psx vertex shader; mirrors the quantization above
+const char* const PACKED_VERTEX_GLSL = R"(
+            layout (location = 0) in vec3 aPos;
+            layout (location = 1) in vec3 aColor;
+            layout (location = 2) in vec2 aTexCoord;
+            layout (location = 7) in vec2 aNormal;
+
+            uniform vec3 u_meshOffset;
+            uniform vec3 u_meshScale;
+
+            vec3 decodePosition() {
+                return u_meshOffset + aPos * u_meshScale;
+            }
+
+            vec2 decodeTexCoord() {
+                return aTexCoord * (1.0 / 1024.0);
+            }
+
+            vec3 decodeNormal() {
+                vec2 e = aNormal * (1.0 / 32767.0);
+                vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+                float t = max(-n.z, 0.0);
+                n.x += n.x >= 0.0 ? -t : t;
+                n.y += n.y >= 0.0 ? -t : t;
+                return normalize(n);
+            }
+)";
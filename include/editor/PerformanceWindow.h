@@ -14,6 +14,7 @@ public:
     float fpsTimer;
     float maxFps;
     float maxFrameTime;
+    float maxPassTime;
 
     PerformanceWindow();
     void Update(float deltaTime);
@@ -21,4 +22,7 @@ public:
     
     void Toggle() { isOpen = !isOpen; }
     bool IsOpen() const { return isOpen; }
+
+private:
+    void DrawPassTimings();
 };
\ No newline at end of file
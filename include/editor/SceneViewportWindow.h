@@ -2,7 +2,7 @@
 
 #include "Camera.h"
 #include "Shader.h"
-#include "Game.h"
+#include "game.h"
 #include <vector>
 
 class ObjectInspectorWindow;
@@ -63,8 +63,6 @@ private:
     void CreateGridGeometry();
     void CreateFramebuffer(int width, int height);
     void ResizeFramebuffer(int width, int height);
-    void perspective(float fovy, float aspect, float zNear, float zFar, float* result);
     
-    bool RayIntersectsBox(const float* rayOrigin, const float* rayDir, const RenderObject& obj, float& distance);
     void ScreenToWorldRay(float screenX, float screenY, float* rayOrigin, float* rayDir, const float* view, const float* projection);
 };
\ No newline at end of file
@@ -4,10 +4,13 @@
 #include "Renderer.h"
 #include "Scene.h"
 #include "Camera.h"
-#include "Model.h"
+#include "model.h"
 #include "Texture.h"
+#include "AssetLoader.h"
+#include "TextureCache.h"
 #include "DebugUI.h"
 #include "PlayerController.h" // Add this include
+#include "InputRecorder.h"
 
 class Game {
 public:
@@ -18,7 +21,21 @@ public:
     PlayerController* playerController; // Add player controller
     
     Model bedModel;
-    Texture bedTexture;
+    
+    // Members are destroyed in reverse order: the loader goes first, so no queued load or
+    // upload still holds a cache texture when the cache itself is destroyed
+    TextureCache textureCache;
+    AssetLoader assetLoader;
+    std::shared_ptr<AssetHandle> bedModelHandle;
+    TextureRef bedTexture;
+    bool testSceneLoaded = false;
+    
+    // Main-thread time per frame spent creating GL objects for finished loads
+    float uploadBudgetMs = 2.0f;
+    
+    float traceCaptureSeconds = 10.0f;
+    InputRecorder inputRecorder;
+    std::string inputRecordingPath = "input.psxinput";
     
     bool Initialize(GLFWwindow* window) {
         camera = Camera(0.0f, 1.7f, 3.0f); // Set eye height to 1.7m (typical player height)
@@ -34,11 +51,10 @@ public:
         // Initialize player controller
         playerController = new PlayerController(&camera);
         
-        if (bedModel.LoadFromFile("assets/GLB/bed.glb")) {
-            if (bedTexture.LoadFromFile("assets/Texture/bed/Bed.png")) {
-                LoadTestScene();
-            }
-        }
+        // Assets stream in on worker threads; the loop keeps rendering until they are ready
+        assetLoader.Initialize();
+        bedModelHandle = assetLoader.LoadModel(&bedModel, "assets/GLB/bed.glb");
+        bedTexture = textureCache.Acquire(assetLoader, "assets/Texture/bed/Bed.png", 8);
         
         return true;
     }
@@ -56,28 +72,81 @@ public:
         };
         
         for (int i = 0; i < 6; i++) {
-            scene.AddObjectAt(&bedModel, positions[i][0], positions[i][1], positions[i][2], &bedTexture);
+            scene.AddObjectAt(&bedModel, positions[i][0], positions[i][1], positions[i][2], bedTexture.Get());
         }
     }
     
     void Update(float deltaTime) {
+        TraceScope trace("Game::Update");
+        assetLoader.ProcessUploads(uploadBudgetMs);
+        if (!testSceneLoaded && bedModelHandle->IsDone() && bedTexture.IsDone()) {
+            if (bedModelHandle->IsReady() && bedTexture.IsReady()) {
+                LoadTestScene();
+            }
+            testSceneLoaded = true;
+        }
+        
         renderer.Update(deltaTime, camera);
         debugUI.Update(deltaTime, *this);
     }
     
     void Render(int screenWidth, int screenHeight) {
+        TraceScope trace("Game::Render");
+        Profiler::Instance().BeginFrame();
         renderer.BeginFrame(camera);
-        scene.Render(renderer);
+        {
+            ProfileScope scope("Scene");
+            scene.Render(renderer);
+        }
         renderer.EndFrame(camera, screenWidth, screenHeight);
         debugUI.Render();
+        Profiler::Instance().EndFrame();
     }
     
-    void ProcessInput(GLFWwindow* window, float deltaTime) {
-        // Use PlayerController for movement instead of direct camera control
-        if (playerController) {
-            playerController->ProcessKeyboardInput(window, deltaTime);
+    // Player movement for one frame, called every frame (playerInput is false in UI mode).
+    // While replaying, the recorded frame drives the controller and its deltaTime replaces
+    // the measured one; returns the deltaTime the rest of the frame should use.
+    float ProcessPlayerInput(GLFWwindow* window, float deltaTime, bool playerInput) {
+        if (!playerController) return deltaTime;
+        
+        InputFrame frame;
+        if (inputRecorder.NextReplayFrame(frame)) {
+            playerController->ProcessMouseMovement(frame.mouseX, frame.mouseY);
+            InputState input;
+            input.keys = frame.keys;
+            if (input.Has(INPUT_PLAYER_ACTIVE)) {
+                playerController->ProcessInput(input, frame.deltaTime);
+            }
+            return frame.deltaTime;
         }
         
+        InputState input;
+        if (playerInput) {
+            input = InputState::FromWindow(window);
+            input.keys |= INPUT_PLAYER_ACTIVE;
+            playerController->ProcessInput(input, deltaTime);
+        }
+        inputRecorder.RecordFrame(deltaTime, input);
+        return deltaTime;
+    }
+    
+    void StartInputRecording(const std::string& path) {
+        if (!playerController) return;
+        inputRecordingPath = path;
+        inputRecorder.StartRecording(playerController->CaptureState());
+        std::cout << "Recording input to " << path << std::endl;
+    }
+    
+    bool StartInputReplay(const std::string& path) {
+        if (!playerController || !inputRecorder.StartReplay(path)) return false;
+        inputRecordingPath = path;
+        playerController->RestoreState(inputRecorder.start);
+        return true;
+    }
+    
+    // Hotkeys; only called in camera mode
+    void ProcessInput(GLFWwindow* window) {
+        
         // Debug UI hotkeys work in both modes
         static bool fPressed = false;
         if (glfwGetKey(window, GLFW_KEY_F) == GLFW_PRESS && !fPressed) {
@@ -162,6 +231,43 @@ public:
             f5Pressed = false;
         }
         
+        // F8 writes the last few seconds of trace events for chrome://tracing / Perfetto
+        static bool f8Pressed = false;
+        if (glfwGetKey(window, GLFW_KEY_F8) == GLFW_PRESS && !f8Pressed) {
+            TraceRecorder::Instance().Flush("trace.json", traceCaptureSeconds);
+            f8Pressed = true;
+        }
+        if (glfwGetKey(window, GLFW_KEY_F8) == GLFW_RELEASE) {
+            f8Pressed = false;
+        }
+        
+        // F9 starts/stops recording player input, F10 replays the last recording
+        static bool f9Pressed = false;
+        if (glfwGetKey(window, GLFW_KEY_F9) == GLFW_PRESS && !f9Pressed) {
+            if (inputRecorder.IsRecording()) {
+                inputRecorder.StopRecording(inputRecordingPath);
+            } else {
+                StartInputRecording(inputRecordingPath);
+            }
+            f9Pressed = true;
+        }
+        if (glfwGetKey(window, GLFW_KEY_F9) == GLFW_RELEASE) {
+            f9Pressed = false;
+        }
+        
+        static bool f10Pressed = false;
+        if (glfwGetKey(window, GLFW_KEY_F10) == GLFW_PRESS && !f10Pressed) {
+            if (inputRecorder.IsReplaying()) {
+                inputRecorder.StopReplay();
+            } else if (!inputRecorder.IsRecording()) {
+                StartInputReplay(inputRecordingPath);
+            }
+            f10Pressed = true;
+        }
+        if (glfwGetKey(window, GLFW_KEY_F10) == GLFW_RELEASE) {
+            f10Pressed = false;
+        }
+        
         // Head bob toggle for testing
         static bool hPressed = false;
         if (glfwGetKey(window, GLFW_KEY_H) == GLFW_PRESS && !hPressed) {
@@ -178,12 +284,27 @@ public:
     
     // Add method for mouse input (called from main.cpp)
     void ProcessMouseMovement(float xOffset, float yOffset) {
+        // Replay supplies its own recorded mouse movement
+        if (inputRecorder.IsReplaying()) return;
+        
         if (playerController) {
             playerController->ProcessMouseMovement(xOffset, yOffset);
+            inputRecorder.AddMouseDelta(xOffset, yOffset);
         }
     }
     
     void Shutdown() {
+        if (inputRecorder.IsRecording()) {
+            inputRecorder.StopRecording(inputRecordingPath);
+        }
+        assetLoader.Shutdown();
+        scene.Clear();
+        bedModel.ReleaseMesh(); // game is a global, so ~Model runs after the arena is gone
+        MeshArena::Instance().Shutdown();
+        bedTexture.Release();
+        textureCache.Clear();   // likewise for packed textures and TextureArrayPool
+        TextureArrayPool::Instance().Shutdown();
+        Profiler::Instance().Shutdown();
         delete playerController; // Clean up player controller
         debugUI.Shutdown();
     }
@@ -4,28 +4,118 @@
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
+#include "CookedMesh.h"
+#include "MappedFile.h"
+#include "MeshArena.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
 #include <vector>
 #include <string>
 #include <iostream>
-
-struct Vertex {
-    float Position[3];
-    float Color[3];
-    float TexCoords[2];
-};
+#include <cmath>
+#include <cfloat>
 
 class Model {
 public:
+    // Only filled when the model is imported through Assimp; a cooked load goes straight to the GPU
     std::vector<Vertex> vertices;
+    std::vector<PackedVertex> packedVertices; // vertices quantized for upload
     std::vector<unsigned int> indices;
-    unsigned int VAO, VBO, EBO;
+    std::vector<uint16_t> shortIndices; // indices narrowed for upload when every vertex fits
+    std::vector<PsxMeshSubmesh> submeshes;
+    std::vector<PsxMeshLod> lods; // lods[0] is full detail; indices holds every level back to back
+    size_t vertexCount = 0;
+    size_t indexCount = 0;        // all levels
+    uint32_t indexSize = sizeof(unsigned int); // 2 when the model has at most 65536 vertices
+
+    // Vertex cache miss ratio before and after the import-time reordering (see MeshOptimizer.h)
+    float acmrSource = 0.0f;
+    float acmrOptimized = 0.0f;
+    MeshAllocation mesh; // where UploadGPU placed the geometry in the shared MeshArena
+
+    // Local-space bounds, filled while the meshes are processed
+    float boundsMin[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+    float boundsMax[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    float boundsCenter[3] = {0.0f, 0.0f, 0.0f};
+    float boundsRadius = 0.0f;
+
+    // Dequantizes PackedVertex positions; derived from the bounds
+    MeshQuantization quantization;
 
     Model() {}
+    ~Model() { ReleaseMesh(); }
+
+    // Hand the geometry's arena range back. Owners with static lifetime must call this before
+    // exit: the arena is a function-local static and may be destroyed before they are
+    void ReleaseMesh() {
+        if (mesh.IsValid()) MeshArena::Instance().Free(mesh);
+    }
+
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
 
+    // Uses the cooked .psxmesh next to path when it is up to date; otherwise imports path
+    // with Assimp and cooks it for the next run
     bool LoadFromFile(const std::string& path) {
+        if (!LoadCPU(path)) {
+            return false;
+        }
+        UploadGPU();
+        return true;
+    }
+
+    // File I/O and vertex processing only, no GL calls; safe to run on a worker thread
+    bool LoadCPU(const std::string& path) {
+        std::string cookedPath = CookedMeshPath(path);
+        if (!CookedMeshIsStale(path, cookedPath) && mapCooked(cookedPath)) {
+            std::cout << "Model loaded (cooked): " << cookedPath << std::endl;
+            return true;
+        }
+
+        if (!importWithAssimp(path)) {
+            return false;
+        }
+
+        if (!writeCooked(cookedPath)) {
+            std::cout << "WARNING::MODEL:: could not write " << cookedPath << std::endl;
+        }
+        return true;
+    }
+
+    // Creates the GL objects from whatever LoadCPU produced; main thread only
+    void UploadGPU() {
+        if (cookedFile.IsOpen()) {
+            setupMesh(cookedFile.Data() + cookedVertexOffset, cookedFile.Data() + cookedIndexOffset);
+            cookedFile.Close();
+        } else {
+            setupMesh(packedVertices.data(), indexSize == 2 ? (const void*)shortIndices.data() : (const void*)indices.data());
+        }
+    }
+
+    static const int MAX_LODS = (int)PSXMESH_MAX_LODS;
+
+    int LodCount() const { return (int)lods.size(); }
+
+    size_t LodTriangles(int lod) const { return lods[lod].indexCount / 3; }
+
+    void Draw(int lod = 0) {
+        MeshArena::Instance().Draw(mesh, lods[lod].firstIndex, lods[lod].indexCount);
+    }
+
+    // Per-instance data comes from MeshArena::SetInstanceBuffer
+    void DrawInstanced(int instanceCount, int lod = 0) {
+        MeshArena::Instance().DrawInstanced(mesh, lods[lod].firstIndex, lods[lod].indexCount, instanceCount);
+    }
+
+private:
+    MappedFile cookedFile;
+    uint64_t cookedVertexOffset = 0;
+    uint64_t cookedIndexOffset = 0;
+
+    bool importWithAssimp(const std::string& path) {
         Assimp::Importer importer;
-        const aiScene* scene = importer.ReadFile(path, 
-            aiProcess_Triangulate | 
+        const aiScene* scene = importer.ReadFile(path,
+            aiProcess_Triangulate |
             aiProcess_FlipUVs |
             aiProcess_GenNormals
         );
@@ -35,37 +125,142 @@ public:
             return false;
         }
 
+        size_t totalVertices = 0, totalIndices = 0;
+        for (unsigned int i = 0; i < scene->mNumMeshes; i++) {
+            totalVertices += scene->mMeshes[i]->mNumVertices;
+            totalIndices += scene->mMeshes[i]->mNumFaces * 3;
+        }
+        vertices.reserve(totalVertices);
+        indices.reserve(totalIndices);
+
         processNode(scene->mRootNode, scene);
-        setupMesh();
+
+        acmrSource = ComputeACMR(indices.data(), indices.size());
+        OptimizeModelMesh(vertices, indices, submeshes);
+        acmrOptimized = ComputeACMR(indices.data(), indices.size());
+        BuildModelLods(vertices, indices, submeshes, lods, MAX_LODS);
+
+        computeBoundingSphere();
+        vertexCount = vertices.size();
+        indexCount = indices.size();
+
+        // Indices are relative to the model's base vertex, so the whole model decides the width
+        indexSize = vertexCount <= 65536 ? 2 : sizeof(unsigned int);
+        shortIndices.clear();
+        if (indexSize == 2) {
+            shortIndices.assign(indices.begin(), indices.end());
+        }
+
+        quantization = MeshQuantization::FromBounds(boundsMin, boundsMax);
+        packedVertices.resize(vertices.size());
+        for (size_t i = 0; i < vertices.size(); i++) {
+            packedVertices[i] = PackVertex(vertices[i], quantization);
+        }
         return true;
     }
 
-    void Draw() {
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+    // Map and validate the cooked file; the mapping stays open until UploadGPU hands the blobs to GL
+    bool mapCooked(const std::string& cookedPath) {
+        if (!cookedFile.Open(cookedPath)) return false;
+
+        const PsxMeshHeader* header = ValidateCookedMesh(cookedFile.Data(), cookedFile.Size(), sizeof(PackedVertex));
+        if (!header || header->indexCount == 0) {
+            cookedFile.Close();
+            return false;
+        }
+
+        for (int axis = 0; axis < 3; axis++) {
+            boundsMin[axis] = header->boundsMin[axis];
+            boundsMax[axis] = header->boundsMax[axis];
+            boundsCenter[axis] = header->boundsCenter[axis];
+        }
+        boundsRadius = header->boundsRadius;
+        acmrSource = header->acmrSource;
+        acmrOptimized = header->acmrOptimized;
+        quantization = MeshQuantization::FromBounds(boundsMin, boundsMax);
+
+        const PsxMeshSubmesh* table = (const PsxMeshSubmesh*)(cookedFile.Data() + header->submeshOffset);
+        submeshes.assign(table, table + header->submeshCount);
+        const PsxMeshLod* lodTable = (const PsxMeshLod*)(table + header->submeshCount);
+        lods.assign(lodTable, lodTable + header->lodCount); // 1..MAX_LODS, checked by the validator
+        vertexCount = header->vertexCount;
+        indexCount = header->indexCount;
+        indexSize = header->indexSize;
+        cookedVertexOffset = header->vertexOffset;
+        cookedIndexOffset = header->indexOffset;
+
+        // Fault the pages in here so the upload on the main thread does not wait on disk
+        volatile unsigned char sink = 0;
+        for (size_t offset = 0; offset < cookedFile.Size(); offset += 4096) {
+            sink += cookedFile.Data()[offset];
+        }
+        (void)sink;
+        return true;
+    }
+
+    bool writeCooked(const std::string& cookedPath) {
+        if (indices.empty()) return false;
+
+        PsxMeshHeader header = {};
+        header.vertexStride = sizeof(PackedVertex);
+        header.indexSize = indexSize;
+        header.vertexCount = (uint32_t)vertices.size();
+        header.indexCount = (uint32_t)indices.size();
+        header.submeshCount = (uint32_t)submeshes.size();
+        header.lodCount = (uint32_t)lods.size();
+        for (int axis = 0; axis < 3; axis++) {
+            header.boundsMin[axis] = boundsMin[axis];
+            header.boundsMax[axis] = boundsMax[axis];
+            header.boundsCenter[axis] = boundsCenter[axis];
+        }
+        header.boundsRadius = boundsRadius;
+        header.acmrSource = acmrSource;
+        header.acmrOptimized = acmrOptimized;
+
+        const void* indexData = indexSize == 2 ? (const void*)shortIndices.data() : (const void*)indices.data();
+        return WriteCookedMesh(cookedPath, header, submeshes.data(), lods.data(), packedVertices.data(), indexData);
     }
 
-private:
     void processNode(aiNode* node, const aiScene* scene) {
         for (unsigned int i = 0; i < node->mNumMeshes; i++) {
             aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
             processMesh(mesh, scene);
         }
-        
+
         for (unsigned int i = 0; i < node->mNumChildren; i++) {
             processNode(node->mChildren[i], scene);
         }
     }
 
     void processMesh(aiMesh* mesh, const aiScene* scene) {
+        // Meshes share one vertex buffer, so each mesh's indices are rebased onto its first vertex
+        PsxMeshSubmesh submesh;
+        submesh.firstVertex = (uint32_t)vertices.size();
+        submesh.vertexCount = mesh->mNumVertices;
+        submesh.firstIndex = (uint32_t)indices.size();
+
         for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
             Vertex vertex;
-            
+
             vertex.Position[0] = mesh->mVertices[i].x;
             vertex.Position[1] = mesh->mVertices[i].y;
             vertex.Position[2] = mesh->mVertices[i].z;
 
+            for (int axis = 0; axis < 3; axis++) {
+                if (vertex.Position[axis] < boundsMin[axis]) boundsMin[axis] = vertex.Position[axis];
+                if (vertex.Position[axis] > boundsMax[axis]) boundsMax[axis] = vertex.Position[axis];
+            }
+
+            if (mesh->mNormals) {
+                vertex.Normal[0] = mesh->mNormals[i].x;
+                vertex.Normal[1] = mesh->mNormals[i].y;
+                vertex.Normal[2] = mesh->mNormals[i].z;
+            } else {
+                vertex.Normal[0] = 0.0f;
+                vertex.Normal[1] = 1.0f;
+                vertex.Normal[2] = 0.0f;
+            }
+
             vertex.Color[0] = 0.8f;
             vertex.Color[1] = 0.7f;
             vertex.Color[2] = 0.6f;
@@ -84,33 +279,42 @@ private:
         for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
             aiFace face = mesh->mFaces[i];
             for (unsigned int j = 0; j < face.mNumIndices; j++) {
-                indices.push_back(face.mIndices[j]);
+                indices.push_back(submesh.firstVertex + face.mIndices[j]);
             }
         }
-    }
 
-    void setupMesh() {
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
-
-        glBindVertexArray(VAO);
-
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        submesh.indexCount = (uint32_t)indices.size() - submesh.firstIndex;
+        submeshes.push_back(submesh);
+    }
 
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-        glEnableVertexAttribArray(0);
+    // Sphere around the AABB centre, sized to the farthest vertex (tighter than the box diagonal)
+    void computeBoundingSphere() {
+        if (vertices.empty()) {
+            for (int axis = 0; axis < 3; axis++) {
+                boundsMin[axis] = boundsMax[axis] = boundsCenter[axis] = 0.0f;
+            }
+            boundsRadius = 0.0f;
+            return;
+        }
 
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Color));
-        glEnableVertexAttribArray(1);
+        for (int axis = 0; axis < 3; axis++) {
+            boundsCenter[axis] = (boundsMin[axis] + boundsMax[axis]) * 0.5f;
+        }
 
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-        glEnableVertexAttribArray(2);
+        float maxDistSq = 0.0f;
+        for (const auto& vertex : vertices) {
+            float dx = vertex.Position[0] - boundsCenter[0];
+            float dy = vertex.Position[1] - boundsCenter[1];
+            float dz = vertex.Position[2] - boundsCenter[2];
+            float distSq = dx * dx + dy * dy + dz * dz;
+            if (distSq > maxDistSq) maxDistSq = distSq;
+        }
+        boundsRadius = sqrt(maxDistSq);
+    }
 
-        glBindVertexArray(0);
+    void setupMesh(const void* vertexData, const void* indexData) {
+        MeshArena& arena = MeshArena::Instance();
+        arena.Free(mesh);
+        mesh = arena.Allocate(vertexData, (uint32_t)vertexCount, indexData, (uint32_t)indexCount, indexSize);
     }
 };
\ No newline at end of file
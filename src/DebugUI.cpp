@@ -4,13 +4,16 @@
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 #include "DebugUI.h"
-#include "Game.h"
+#include "game.h"
 #include "editor/ConsoleWindow.h"
 #include "editor/PerformanceWindow.h"
 #include "editor/SceneViewportWindow.h"
 #include "editor/ObjectInspectorWindow.h"
 #include "editor/OutlinerWindow.h"
 #include "editor/ImGuiTheme.h"
+#include "Profiler.h"
+#include "GLState.h"
+#include "MeshArena.h"
 
 bool DebugUI::Initialize(GLFWwindow* window) {
     IMGUI_CHECKVERSION();
@@ -67,8 +70,12 @@ void DebugUI::Update(float deltaTime, Game& game) {
 }
 
 void DebugUI::Render() {
+    ProfileScope scope("ImGui");
     ImGui::Render();
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    
+    // The ImGui backend sets and restores GL state directly, out of sight of the cache
+    GLState::Instance().Invalidate();
 }
 
 void DebugUI::ToggleDebugWindow() {
@@ -112,6 +119,21 @@ void DebugUI::RenderDebugWindow(Game& game) {
     
     if (ImGui::CollapsingHeader("Scene Info")) {
         ImGui::Text("Objects in scene: %d", (int)game.scene.objects.size());
+        ImGui::Text("Visible: %d  Culled: %d", game.scene.visibleCount, game.scene.culledCount);
+        ImGui::Text("Draw calls: %d  Triangles: %lld", game.renderer.stats.drawCalls, game.renderer.stats.triangles);
+        ImGui::Text("GL state calls: %d  Skipped: %d", GLState::Instance().stats.issued, GLState::Instance().stats.skipped);
+        MeshArena& arena = MeshArena::Instance();
+        ImGui::Text("Mesh arena: %u / %u vertices  %zu / %zu KB indices",
+                    arena.VerticesUsed(), arena.VertexCapacity(), arena.IndexBytesUsed() / 1024, arena.IndexBytesCapacity() / 1024);
+        TextureCache& textures = game.textureCache;
+        ImGui::Text("Textures: %d resident  %zu / %zu KB  (%d entries, %d deduplicated)",
+                    textures.ResidentCount(), textures.ResidentBytes() / 1024, textures.budgetBytes / 1024,
+                    textures.EntryCount(), textures.DedupedCount());
+        TextureArrayPool& pool = TextureArrayPool::Instance();
+        ImGui::Text("Texture arrays: %d pages  %d layers  %zu KB",
+                    pool.PageCount(), pool.LayersUsed(), pool.BytesAllocated() / 1024);
+        ImGui::Checkbox("Cull Beyond Fog End", &game.renderer.cullBeyondFog);
+        ImGui::Text("Assets loading: %d", game.assetLoader.GetPendingCount());
         ImGui::Text("Camera Position: (%.2f, %.2f, %.2f)", 
             game.camera.Position[0], game.camera.Position[1], game.camera.Position[2]);
         ImGui::Text("Camera Front: (%.2f, %.2f, %.2f)", 
@@ -142,6 +164,16 @@ void DebugUI::RenderDebugWindow(Game& game) {
         ImGui::SliderFloat("Height End", &game.renderer.fog.heightEnd, -5.0f, 10.0f);
         ImGui::ColorEdit3("Fog Color", game.renderer.fog.color);
     }
+    
+    if (ImGui::CollapsingHeader("Mesh LOD")) {
+        LodSettings& lod = game.renderer.lod;
+        const RenderStats& stats = game.renderer.stats;
+        ImGui::Checkbox("Enable LOD", &lod.enabled);
+        ImGui::SliderFloat3("Thresholds (px)", lod.thresholds, 4.0f, 240.0f);
+        ImGui::SliderFloat("Hysteresis", &lod.hysteresis, 0.0f, 0.5f);
+        ImGui::Text("Objects per LOD: %d / %d / %d / %d",
+                    stats.lodObjects[0], stats.lodObjects[1], stats.lodObjects[2], stats.lodObjects[3]);
+    }
 
     // Add this section to your existing RenderDebugWindow function in DebugUI.cpp
 // Replace the existing "Lighting Controls" section with this enhanced version:
@@ -291,12 +323,7 @@ if (ImGui::CollapsingHeader("💡 Enhanced Lighting System", ImGuiTreeNodeFlags_
     
     if (ImGui::CollapsingHeader("Particle System")) {
         ImGui::SliderFloat("Spawn Rate", &game.renderer.particles->spawnRate, 1.0f, 200.0f);
-        
-        int activeParticles = 0;
-        for (const auto& p : game.renderer.particles->particles) {
-            if (p.active) activeParticles++;
-        }
-        ImGui::Text("Active Particles: %d / %d", activeParticles, (int)game.renderer.particles->particles.size());
+        ImGui::Text("Active Particles: %d / %d", game.renderer.particles->liveCount, game.renderer.particles->maxParticles);
     }
     
     if (ImGui::CollapsingHeader("Post Processing")) {
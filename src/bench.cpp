@@ -0,0 +1,334 @@
+// Headless benchmark: renders a scene through PSXRenderer on an EGL pbuffer (works on Mesa
+// llvmpipe with no display or GPU), flies a scripted camera at a fixed timestep and writes
+// frame-time statistics, per-pass timings and draw counts as JSON.
+//
+//   PSXHorrorEngine_bench [--scene test|grid] [--frames N] [--warmup N]
+//                         [--width W] [--height H] [--clut 0|4|8] [--out bench.json]
+
+#include <glad/glad.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "Renderer.h"
+#include "Scene.h"
+#include "Camera.h"
+#include "model.h"
+#include "Texture.h"
+#include "AssetLoader.h"
+#include "TextureCache.h"
+#include "Profiler.h"
+#include "ProgramCache.h"
+#include "GLState.h"
+
+struct BenchOptions {
+    std::string scene = "test";
+    std::string outPath = "bench.json";
+    int frames = 1000;
+    int warmup = 60;
+    int width = 960;
+    int height = 720;
+    int clutBits = 8; // texture palette depth, 0 for direct colour; the game uses 8
+    float timestep = 1.0f / 60.0f;
+};
+
+struct HeadlessContext {
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLSurface surface = EGL_NO_SURFACE;
+    EGLContext context = EGL_NO_CONTEXT;
+
+    // Prefer Mesa's surfaceless platform so no X/Wayland server is needed
+    bool Create(int width, int height) {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+            (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (getPlatformDisplay) {
+            display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+        }
+        if (display == EGL_NO_DISPLAY) {
+            display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        }
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL)) {
+            std::cerr << "Failed to initialize EGL" << std::endl;
+            return false;
+        }
+
+        const EGLint configAttribs[] = {
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+            EGL_DEPTH_SIZE, 24,
+            EGL_NONE
+        };
+        EGLConfig config;
+        EGLint configCount = 0;
+        if (!eglChooseConfig(display, configAttribs, &config, 1, &configCount) || configCount == 0) {
+            std::cerr << "No EGL config with pbuffer + desktop GL support" << std::endl;
+            return false;
+        }
+
+        const EGLint surfaceAttribs[] = { EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+        surface = eglCreatePbufferSurface(display, config, surfaceAttribs);
+        if (surface == EGL_NO_SURFACE) {
+            std::cerr << "Failed to create EGL pbuffer" << std::endl;
+            return false;
+        }
+
+        eglBindAPI(EGL_OPENGL_API);
+        const EGLint contextAttribs[] = {
+            EGL_CONTEXT_MAJOR_VERSION, 3,
+            EGL_CONTEXT_MINOR_VERSION, 3,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE
+        };
+        context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+        if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, surface, surface, context)) {
+            std::cerr << "Failed to create a GL 3.3 core context" << std::endl;
+            return false;
+        }
+
+        if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+            std::cerr << "Failed to initialize GLAD" << std::endl;
+            return false;
+        }
+
+        ProgramCache::Instance().Initialize((GLADloadproc)eglGetProcAddress);
+        return true;
+    }
+
+    void Destroy() {
+        if (display == EGL_NO_DISPLAY) return;
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (context != EGL_NO_CONTEXT) eglDestroyContext(display, context);
+        if (surface != EGL_NO_SURFACE) eglDestroySurface(display, surface);
+        eglTerminate(display);
+        display = EGL_NO_DISPLAY;
+    }
+};
+
+static bool ParseOptions(int argc, char** argv, BenchOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--scene" && hasValue) options.scene = argv[++i];
+        else if (arg == "--frames" && hasValue) options.frames = atoi(argv[++i]);
+        else if (arg == "--warmup" && hasValue) options.warmup = atoi(argv[++i]);
+        else if (arg == "--width" && hasValue) options.width = atoi(argv[++i]);
+        else if (arg == "--height" && hasValue) options.height = atoi(argv[++i]);
+        else if (arg == "--clut" && hasValue) options.clutBits = atoi(argv[++i]);
+        else if (arg == "--out" && hasValue) options.outPath = argv[++i];
+        else {
+            std::cerr << "Unknown or incomplete argument: " << arg << std::endl;
+            return false;
+        }
+    }
+    return options.frames > 0 && options.warmup >= 0 && options.width > 0 && options.height > 0 &&
+           (options.clutBits == 0 || options.clutBits == 4 || options.clutBits == 8);
+}
+
+// "test" is the game's six-bed layout; "grid" is a 32x32 field of beds for batching and culling load
+static bool LoadBenchScene(const std::string& name, Scene& scene, Model* model, Texture* texture) {
+    scene.Clear();
+    if (name == "test") {
+        float positions[][3] = {
+            {0.0f, 0.0f, 0.0f},
+            {3.0f, 0.0f, -2.0f},
+            {-3.0f, 0.0f, -4.0f},
+            {0.0f, 0.0f, -6.0f},
+            {5.0f, 0.0f, -8.0f},
+            {-5.0f, 0.0f, -10.0f}
+        };
+        for (int i = 0; i < 6; i++) {
+            scene.AddObjectAt(model, positions[i][0], positions[i][1], positions[i][2], texture);
+        }
+        return true;
+    }
+    if (name == "grid") {
+        for (int z = 0; z < 32; z++) {
+            for (int x = 0; x < 32; x++) {
+                scene.AddObjectAt(model, (x - 16) * 3.0f, 0.0f, (z - 16) * 3.0f, texture);
+            }
+        }
+        return true;
+    }
+    std::cerr << "Unknown scene: " << name << std::endl;
+    return false;
+}
+
+// Slow orbit around the origin at eye height, always looking a little ahead along the path
+static void FlyCamera(Camera& camera, float time) {
+    float angle = time * 0.3f;
+    float radius = 8.0f + 2.0f * sinf(time * 0.17f);
+    camera.Position[0] = cosf(angle) * radius;
+    camera.Position[1] = 1.7f;
+    camera.Position[2] = sinf(angle) * radius;
+    camera.Yaw = angle * 180.0f / 3.14159265359f + 180.0f + 20.0f * sinf(time * 0.5f);
+    camera.Pitch = -5.0f + 5.0f * sinf(time * 0.23f);
+    camera.updateCameraVectors();
+}
+
+static float Percentile(const std::vector<float>& sorted, float p) {
+    if (sorted.empty()) return 0.0f;
+    size_t rank = (size_t)ceil(p / 100.0f * sorted.size());
+    if (rank < 1) rank = 1;
+    return sorted[std::min(rank, sorted.size()) - 1];
+}
+
+// Per-frame counters summed over the measured frames
+struct BenchTotals {
+    double drawCalls = 0.0;
+    double triangles = 0.0;
+    double stateCalls = 0.0;
+    double stateCallsSkipped = 0.0;
+};
+
+static bool WriteReport(const BenchOptions& options, const std::vector<float>& frameMs,
+                        const std::vector<double>& passCpuMs, const std::vector<double>& passGpuMs,
+                        const BenchTotals& totals, const Scene& scene, const Model& model, const TextureCache& textures, const char* glRenderer) {
+    FILE* file = fopen(options.outPath.c_str(), "w");
+    if (!file) {
+        std::cerr << "Could not write " << options.outPath << std::endl;
+        return false;
+    }
+
+    std::vector<float> sorted = frameMs;
+    std::sort(sorted.begin(), sorted.end());
+    double total = 0.0;
+    for (float ms : frameMs) total += ms;
+    double frames = (double)frameMs.size();
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"scene\": \"%s\",\n", options.scene.c_str());
+    fprintf(file, "  \"renderer\": \"%s\",\n", glRenderer ? glRenderer : "unknown");
+    fprintf(file, "  \"frames\": %d,\n", (int)frameMs.size());
+    fprintf(file, "  \"width\": %d,\n  \"height\": %d,\n", options.width, options.height);
+    fprintf(file, "  \"objects\": %d,\n", (int)scene.objects.size());
+    fprintf(file, "  \"frame_ms\": { \"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f },\n",
+            total / frames, Percentile(sorted, 50.0f), Percentile(sorted, 95.0f), Percentile(sorted, 99.0f), sorted.back());
+    fprintf(file, "  \"draw_calls_per_frame\": %.2f,\n", totals.drawCalls / frames);
+    fprintf(file, "  \"triangles_per_frame\": %.1f,\n", totals.triangles / frames);
+    fprintf(file, "  \"gl_state_calls_per_frame\": %.2f,\n", totals.stateCalls / frames);
+    fprintf(file, "  \"gl_state_calls_skipped_per_frame\": %.2f,\n", totals.stateCallsSkipped / frames);
+    fprintf(file, "  \"model_acmr_before\": %.3f,\n  \"model_acmr_after\": %.3f,\n", model.acmrSource, model.acmrOptimized);
+    fprintf(file, "  \"model_index_size\": %u,\n", model.indexSize);
+    fprintf(file, "  \"texture_clut_bits\": %d,\n  \"texture_bytes\": %zu,\n", options.clutBits, textures.ResidentBytes());
+
+    const auto& passes = Profiler::Instance().passes;
+    fprintf(file, "  \"passes\": [\n");
+    for (size_t i = 0; i < passes.size(); i++) {
+        fprintf(file, "    { \"name\": \"%s\", \"depth\": %d, \"cpu_ms\": %.4f, \"gpu_ms\": %.4f }%s\n",
+                passes[i].name, passes[i].depth, passCpuMs[i] / frames, passGpuMs[i] / frames,
+                i + 1 < passes.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+
+    return fclose(file) == 0;
+}
+
+// Everything GL-owning lives in here so it is destroyed while the context is still current
+static int RunBenchmark(const BenchOptions& options, const char* glRenderer) {
+    PSXRenderer renderer;
+    Scene scene;
+    Camera camera(0.0f, 1.7f, 3.0f);
+    Model model;
+
+    if (!renderer.Initialize()) {
+        return 1;
+    }
+    renderer.SetAspectRatio((float)options.width / (float)options.height);
+
+    TextureCache textures; // declared first so the loader is destroyed before it
+
+    // No worker threads: assets load synchronously before timing starts
+    AssetLoader loader;
+    auto modelHandle = loader.LoadModel(&model, "assets/GLB/bed.glb");
+    TextureRef texture = textures.Acquire(loader, "assets/Texture/bed/Bed.png", options.clutBits);
+    if (!modelHandle->IsReady() || !texture.IsReady() ||
+        !LoadBenchScene(options.scene, scene, &model, texture.Get())) {
+        return 1;
+    }
+
+    std::vector<float> frameMs;
+    frameMs.reserve(options.frames);
+    std::vector<double> passCpuMs, passGpuMs;
+    BenchTotals totals;
+
+    Profiler& profiler = Profiler::Instance();
+    int totalFrames = options.warmup + options.frames;
+    for (int frame = 0; frame < totalFrames; frame++) {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        FlyCamera(camera, frame * options.timestep);
+        renderer.Update(options.timestep, camera);
+
+        profiler.BeginFrame();
+        renderer.BeginFrame(camera);
+        {
+            ProfileScope scope("Scene");
+            scene.Render(renderer);
+        }
+        renderer.EndFrame(camera, options.width, options.height);
+        profiler.EndFrame();
+
+        // Include the GPU (llvmpipe: the rasterizer threads) in the frame time
+        glFinish();
+        float ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        if (frame < options.warmup) continue;
+
+        frameMs.push_back(ms);
+        totals.drawCalls += renderer.stats.drawCalls;
+        totals.triangles += (double)renderer.stats.triangles;
+        totals.stateCalls += GLState::Instance().stats.issued;
+        totals.stateCallsSkipped += GLState::Instance().stats.skipped;
+
+        passCpuMs.resize(profiler.passes.size(), 0.0);
+        passGpuMs.resize(profiler.passes.size(), 0.0);
+        for (size_t i = 0; i < profiler.passes.size(); i++) {
+            passCpuMs[i] += profiler.passes[i].cpuMs;
+            passGpuMs[i] += profiler.passes[i].gpuMs; // lags a few frames, fine for an average
+        }
+    }
+    profiler.Shutdown();
+
+    if (!WriteReport(options, frameMs, passCpuMs, passGpuMs, totals, scene, model, textures, glRenderer)) {
+        return 1;
+    }
+    std::cout << "Wrote " << options.outPath << " (" << frameMs.size() << " frames)" << std::endl;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    if (!ParseOptions(argc, argv, options)) {
+        std::cerr << "Usage: PSXHorrorEngine_bench [--scene test|grid] [--frames N] [--warmup N] "
+                     "[--width W] [--height H] [--clut 0|4|8] [--out file.json]" << std::endl;
+        return 1;
+    }
+
+    HeadlessContext headless;
+    if (!headless.Create(options.width, options.height)) {
+        headless.Destroy();
+        return 1;
+    }
+
+    const char* glRenderer = (const char*)glGetString(GL_RENDERER);
+    std::cout << "Benchmark renderer: " << glRenderer << std::endl;
+
+    GLState::Instance().Viewport(0, 0, options.width, options.height);
+    GLState::Instance().SetDepthTest(true);
+    glDisable(GL_DITHER);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    int result = RunBenchmark(options, glRenderer);
+    TextureArrayPool::Instance().Shutdown();
+    MeshArena::Instance().Shutdown();
+
+    headless.Destroy();
+    return result;
+}
@@ -1,5 +1,10 @@
 #include "editor/ConsoleWindow.h"
+#include "Trace.h"
 #include <imgui.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <sstream>
 
 ConsoleWindow::ConsoleWindow() : isOpen(true) {
     inputBuffer[0] = '\0';
@@ -121,6 +126,37 @@ void ConsoleWindow::ExecCommand(const char* command_line) {
         AddLog("  clear - Clear console");
         AddLog("  help - Show this help");
         AddLog("  history - Show command history");
+        AddLog("  trace [seconds] [file] - Write a Chrome trace of the last seconds (default 10, trace.json)");
+    } else if (strncmp(command_line, "trace", 5) == 0 && (command_line[5] == '\0' || command_line[5] == ' ')) {
+        // Arguments are optional and separate: a first token that isn't a number is the path
+        float seconds = 10.0f;
+        std::string path = "trace.json";
+        std::istringstream args(command_line + 5);
+        std::string first, second, extra;
+        args >> first >> second >> extra;
+
+        bool ok = extra.empty();
+        if (!first.empty()) {
+            char* end = nullptr;
+            float value = strtof(first.c_str(), &end);
+            if (*end == '\0') {
+                seconds = value;
+                if (!second.empty()) path = second;
+            } else {
+                path = first;
+                ok = ok && second.empty();
+            }
+        }
+
+        if (!ok) {
+            AddLog("[ERROR] Usage: trace [seconds] [file]");
+        } else if (!(seconds > 0.0f) || !std::isfinite(seconds)) {
+            AddLog("[ERROR] Trace length must be a positive number of seconds");
+        } else if (TraceRecorder::Instance().Flush(path, seconds)) {
+            AddLog("[INFO] Trace written to " + path);
+        } else {
+            AddLog("[ERROR] Could not write " + path);
+        }
     } else if (strcmp(command_line, "history") == 0) {
         int first = history.size() - 10;
         for (int i = first > 0 ? first : 0; i < history.size(); i++) {
@@ -151,6 +187,7 @@ int ConsoleWindow::TextEditCallback(ImGuiInputTextCallbackData* data) {
             candidates.push_back("clear");
             candidates.push_back("help");
             candidates.push_back("history");
+            candidates.push_back("trace");
             
             std::vector<std::string> matches;
             for (auto& candidate : candidates) {
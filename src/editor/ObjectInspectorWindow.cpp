@@ -27,7 +27,7 @@ void ObjectInspectorWindow::Draw(Game& game) {
     
     if (ImGui::CollapsingHeader("Transform", ImGuiTreeNodeFlags_DefaultOpen)) {
         ImGui::Text("Position:");
-        ImGui::DragFloat3("##Position", obj.transform.position, 0.1f, -100.0f, 100.0f);
+        bool transformChanged = ImGui::DragFloat3("##Position", obj.transform.position, 0.1f, -100.0f, 100.0f);
         
         ImGui::Text("Rotation:");
         float rotationDegrees[3] = {
@@ -39,23 +39,30 @@ void ObjectInspectorWindow::Draw(Game& game) {
             obj.transform.rotation[0] = rotationDegrees[0] * 0.0174533f;
             obj.transform.rotation[1] = rotationDegrees[1] * 0.0174533f;
             obj.transform.rotation[2] = rotationDegrees[2] * 0.0174533f;
+            transformChanged = true;
         }
         
         ImGui::Text("Scale:");
-        ImGui::DragFloat3("##Scale", obj.transform.scale, 0.01f, 0.1f, 10.0f);
+        transformChanged |= ImGui::DragFloat3("##Scale", obj.transform.scale, 0.01f, 0.1f, 10.0f);
         
         if (ImGui::Button("Reset Transform")) {
             obj.transform.position[0] = obj.transform.position[1] = obj.transform.position[2] = 0.0f;
             obj.transform.rotation[0] = obj.transform.rotation[1] = obj.transform.rotation[2] = 0.0f;
             obj.transform.scale[0] = obj.transform.scale[1] = obj.transform.scale[2] = 1.0f;
+            transformChanged = true;
+        }
+        
+        if (transformChanged) {
+            game.scene.NotifyTransformChanged(selectedObjectIndex);
         }
     }
     
     if (ImGui::CollapsingHeader("Rendering")) {
         ImGui::Checkbox("Use Texture", &obj.useTexture);
+        ImGui::Checkbox("Transparent", &obj.transparent);
         
         if (obj.model) {
-            ImGui::Text("Model: Loaded (%zu vertices)", obj.model->vertices.size());
+            ImGui::Text("Model: Loaded (%zu vertices)", obj.model->vertexCount);
         } else {
             ImGui::Text("Model: None");
         }
@@ -99,8 +106,10 @@ void ObjectInspectorWindow::DuplicateObject(Game& game, int objectIndex) {
     RenderObject duplicate = original;
     
     duplicate.transform.position[0] += 2.0f;
+    duplicate.transform.MarkDirty();
     
     game.scene.objects.push_back(duplicate);
+    game.scene.NotifyObjectsChanged();
     selectedObjectIndex = game.scene.objects.size() - 1;
 }
 
@@ -108,6 +117,7 @@ void ObjectInspectorWindow::DeleteObject(Game& game, int objectIndex) {
     if (objectIndex < 0 || objectIndex >= game.scene.objects.size()) return;
     
     game.scene.objects.erase(game.scene.objects.begin() + objectIndex);
+    game.scene.NotifyObjectsChanged();
     
     if (selectedObjectIndex >= objectIndex) {
         selectedObjectIndex--;
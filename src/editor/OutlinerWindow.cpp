@@ -20,8 +20,8 @@ void OutlinerWindow::Draw(Game& game) {
     
     if (ImGui::BeginPopup("AddObjectPopup")) {
         if (ImGui::MenuItem("Add Bed")) {
-            if (game.bedModel.vertices.size() > 0) {
-                game.scene.AddObjectAt(&game.bedModel, 0.0f, 0.0f, 0.0f, &game.bedTexture);
+            if (game.bedModelHandle && game.bedModelHandle->IsReady()) {
+                game.scene.AddObjectAt(&game.bedModel, 0.0f, 0.0f, 0.0f, game.bedTexture.Get());
             }
         }
         if (ImGui::MenuItem("Add Empty Object")) {
@@ -79,10 +79,13 @@ void OutlinerWindow::Draw(Game& game) {
                 if (ImGui::MenuItem("Duplicate")) {
                     RenderObject duplicate = obj;
                     duplicate.transform.position[0] += 2.0f;
+                    duplicate.transform.MarkDirty();
                     game.scene.objects.push_back(duplicate);
+                    game.scene.NotifyObjectsChanged();
                 }
                 if (ImGui::MenuItem("Delete")) {
                     game.scene.objects.erase(game.scene.objects.begin() + i);
+                    game.scene.NotifyObjectsChanged();
                     if (inspectorWindow && inspectorWindow->GetSelectedObject() >= i) {
                         int newSelection = inspectorWindow->GetSelectedObject() - 1;
                         if (newSelection >= game.scene.objects.size()) {
@@ -1,4 +1,5 @@
 #include "editor/PerformanceWindow.h"
+#include "Profiler.h"
 #include <imgui.h>
 
 PerformanceWindow::PerformanceWindow() : isOpen(false) {
@@ -13,6 +14,7 @@ PerformanceWindow::PerformanceWindow() : isOpen(false) {
     fpsTimer = 0.0f;
     maxFps = 120.0f;
     maxFrameTime = 33.0f;
+    maxPassTime = 8.0f;
 }
 
 void PerformanceWindow::Update(float deltaTime) {
@@ -54,9 +56,13 @@ void PerformanceWindow::Draw() {
     
     ImGui::Separator();
     
+    DrawPassTimings();
+    
     if (ImGui::CollapsingHeader("Settings")) {
         ImGui::SliderFloat("Max FPS Scale", &maxFps, 60.0f, 240.0f);
         ImGui::SliderFloat("Max Frame Time Scale (ms)", &maxFrameTime, 16.0f, 100.0f);
+        ImGui::SliderFloat("Max Pass Time Scale (ms)", &maxPassTime, 1.0f, 33.0f);
+        ImGui::Checkbox("Profile Passes", &Profiler::Instance().enabled);
         
         if (ImGui::Button("Reset Graphs")) {
             for (int i = 0; i < HISTORY_SIZE; i++) {
@@ -86,8 +92,49 @@ void PerformanceWindow::Draw() {
         ImGui::BulletText("F1 - Toggle debug window");
         ImGui::BulletText("F2 - Toggle performance window");
         ImGui::BulletText("F5 - Skybox info");
+        ImGui::BulletText("F8 - Write trace.json");
+        ImGui::BulletText("F9 - Record player input");
+        ImGui::BulletText("F10 - Replay recorded input");
         ImGui::BulletText("F11 - Toggle fullscreen");
     }
     
     ImGui::End();
-}
\ No newline at end of file
+}
+
+// GPU numbers lag the CPU ones by a few frames because queries are read back without waiting
+void PerformanceWindow::DrawPassTimings() {
+    if (!ImGui::CollapsingHeader("Pass Timings", ImGuiTreeNodeFlags_DefaultOpen)) return;
+    
+    Profiler& profiler = Profiler::Instance();
+    if (profiler.passes.empty()) {
+        ImGui::Text("No passes recorded yet");
+        return;
+    }
+    
+    ImGui::Text("Pass");
+    ImGui::SameLine(180);
+    ImGui::Text("CPU ms");
+    ImGui::SameLine(260);
+    ImGui::Text("GPU ms");
+    
+    for (const auto& pass : profiler.passes) {
+        float indent = pass.depth * 12.0f;
+        if (indent > 0.0f) ImGui::Indent(indent);
+        bool expanded = ImGui::TreeNode(pass.name);
+        if (indent > 0.0f) ImGui::Unindent(indent);
+        ImGui::SameLine(180);
+        ImGui::Text("%.3f", pass.cpuMs);
+        ImGui::SameLine(260);
+        ImGui::Text("%.3f", pass.gpuMs);
+        
+        if (expanded) {
+            ImGui::PlotLines("CPU", pass.cpuHistory, Profiler::HISTORY_SIZE, profiler.cpuHistoryOffset, nullptr, 0.0f, maxPassTime, ImVec2(0, 40));
+            ImGui::PlotLines("GPU", pass.gpuHistory, Profiler::HISTORY_SIZE, profiler.gpuHistoryOffset, nullptr, 0.0f, maxPassTime, ImVec2(0, 40));
+            ImGui::TreePop();
+        }
+    }
+    
+    if (profiler.droppedGpuFrames > 0) {
+        ImGui::TextDisabled("GPU frames skipped (results not ready): %d", profiler.droppedGpuFrames);
+    }
+}
@@ -2,7 +2,10 @@
 #include "editor/ObjectInspectorWindow.h"
 #include <imgui.h>
 #include <glad/glad.h>
+#include "GLState.h"
+#include "PsxMath.h"
 #include <cmath>
+#include <cstring>
 
 SceneViewportWindow::SceneViewportWindow() : isOpen(false) {
     viewportCamera = Camera(0.0f, 5.0f, 10.0f);
@@ -157,13 +160,14 @@ void SceneViewportWindow::HandleInput(Game& game) {
 }
 
 void SceneViewportWindow::RenderViewport(Game& game) {
-    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
-    glViewport(0, 0, framebufferWidth, framebufferHeight);
+    GLState& state = GLState::Instance();
+    state.BindFramebuffer(framebuffer);
+    state.Viewport(0, 0, framebufferWidth, framebufferHeight);
+    game.renderer.SetOpaqueState();
     
     glClearColor(0.2f, 0.2f, 0.25f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     
-    glEnable(GL_DEPTH_TEST);
     if (showWireframe) {
         glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
     } else {
@@ -175,7 +179,7 @@ void SceneViewportWindow::RenderViewport(Game& game) {
     
     float projection[16];
     float aspect = (float)framebufferWidth / (float)framebufferHeight;
-    perspective(45.0f, aspect, 0.1f, 100.0f, projection);
+    Mat4Perspective(45.0f, aspect, 0.1f, 100.0f).Store(projection);
     
     if (showGrid) {
         RenderGrid(view, projection);
@@ -187,7 +191,7 @@ void SceneViewportWindow::RenderViewport(Game& game) {
         RenderGizmos(game, view, projection);
     }
     
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    state.BindFramebuffer(0);
 }
 
 void SceneViewportWindow::RenderGrid(const float* view, const float* projection) {
@@ -210,43 +214,33 @@ void SceneViewportWindow::RenderGrid(const float* view, const float* projection)
     };
     gridShader->setMat4("model", modelMatrix);
     
-    glBindVertexArray(gridVAO);
+    GLState::Instance().BindVertexArray(gridVAO);
     glDrawElements(GL_LINES, gridIndexCount, GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
 }
 
 void SceneViewportWindow::RenderSceneObjects(Game& game, const float* view, const float* projection) {
     if (!game.renderer.psxShader) return;
     
-    game.renderer.psxShader->use();
-    game.renderer.psxShader->setMat4("view", view);
-    game.renderer.psxShader->setMat4("projection", projection);
-    game.renderer.psxShader->setFloat("u_snapResolution", 128.0f);
+    // Start from the game's frame constants and override what the editor view needs
+    FrameConstants constants = game.renderer.frameConstants.data;
+    memcpy(constants.view, view, sizeof(constants.view));
+    memcpy(constants.projection, projection, sizeof(constants.projection));
+    constants.snapResolution = 128.0f;
     
-    game.renderer.psxShader->setFloat("fogStart", 50.0f);
-    game.renderer.psxShader->setFloat("fogEnd", 100.0f);
-    game.renderer.psxShader->setVec3("fogColor", 0.2f, 0.2f, 0.25f);
+    constants.fogStart = 50.0f;
+    constants.fogEnd = 100.0f;
+    constants.fogColor[0] = 0.2f; constants.fogColor[1] = 0.2f; constants.fogColor[2] = 0.25f;
     
-    game.renderer.psxShader->setBool("spotlightEnabled", false);
-    game.renderer.psxShader->setVec3("ambientColor", 0.4f, 0.4f, 0.4f);
-    game.renderer.psxShader->setFloat("ambientIntensity", 1.0f);
+    constants.spotlightEnabled = 0;
+    constants.ambientColor[0] = constants.ambientColor[1] = constants.ambientColor[2] = 0.4f;
+    constants.ambientIntensity = 1.0f;
+    game.renderer.frameConstants.Upload(constants);
     
-    for (const auto& obj : game.scene.objects) {
-        game.renderer.psxShader->setBool("useTexture", obj.useTexture);
-        
-        if (obj.useTexture && obj.texture) {
-            obj.texture->Bind(0);
-            game.renderer.psxShader->setInt("ourTexture", 0);
-        }
-        
-        float modelMatrix[16];
-        obj.transform.GetMatrix(modelMatrix);
-        game.renderer.psxShader->setMat4("model", modelMatrix);
-        
-        if (obj.model) {
-            obj.model->Draw();
-        }
-    }
+    Frustum viewportFrustum;
+    viewportFrustum.Build(view, projection);
+    
+    game.renderer.psxShader->use();
+    game.scene.Render(game.renderer, viewportFrustum, view);
 }
 
 void SceneViewportWindow::RenderGizmos(Game& game, const float* view, const float* projection) {
@@ -272,25 +266,13 @@ void SceneViewportWindow::HandleObjectSelection(Game& game) {
     
     float projection[16];
     float aspect = (float)framebufferWidth / (float)framebufferHeight;
-    perspective(45.0f, aspect, 0.1f, 100.0f, projection);
+    Mat4Perspective(45.0f, aspect, 0.1f, 100.0f).Store(projection);
     
     float rayOrigin[3], rayDir[3];
     ScreenToWorldRay(relativeX, relativeY, rayOrigin, rayDir, view, projection);
     
-    int closestObject = -1;
-    float closestDistance = 1000.0f;
-    
-    for (int i = 0; i < game.scene.objects.size(); i++) {
-        const RenderObject& obj = game.scene.objects[i];
-        
-        float distance;
-        if (RayIntersectsBox(rayOrigin, rayDir, obj, distance)) {
-            if (distance < closestDistance) {
-                closestDistance = distance;
-                closestObject = i;
-            }
-        }
-    }
+    float closestDistance;
+    int closestObject = game.scene.Raycast(rayOrigin, rayDir, 1000.0f, closestDistance);
     
     if (inspectorWindow) {
         inspectorWindow->SetSelectedObject(closestObject);
@@ -301,60 +283,6 @@ void SceneViewportWindow::SetInspectorWindow(ObjectInspectorWindow* inspector) {
     inspectorWindow = inspector;
 }
 
-bool SceneViewportWindow::RayIntersectsBox(const float* rayOrigin, const float* rayDir, const RenderObject& obj, float& distance) {
-    float boxMin[3] = {
-        obj.transform.position[0] - obj.transform.scale[0],
-        obj.transform.position[1] - obj.transform.scale[1],
-        obj.transform.position[2] - obj.transform.scale[2]
-    };
-    
-    float boxMax[3] = {
-        obj.transform.position[0] + obj.transform.scale[0],
-        obj.transform.position[1] + obj.transform.scale[1],
-        obj.transform.position[2] + obj.transform.scale[2]
-    };
-    
-    float tMin = (boxMin[0] - rayOrigin[0]) / rayDir[0];
-    float tMax = (boxMax[0] - rayOrigin[0]) / rayDir[0];
-    
-    if (tMin > tMax) {
-        float temp = tMin;
-        tMin = tMax;
-        tMax = temp;
-    }
-    
-    float tyMin = (boxMin[1] - rayOrigin[1]) / rayDir[1];
-    float tyMax = (boxMax[1] - rayOrigin[1]) / rayDir[1];
-    
-    if (tyMin > tyMax) {
-        float temp = tyMin;
-        tyMin = tyMax;
-        tyMax = temp;
-    }
-    
-    if (tMin > tyMax || tyMin > tMax) return false;
-    
-    if (tyMin > tMin) tMin = tyMin;
-    if (tyMax < tMax) tMax = tyMax;
-    
-    float tzMin = (boxMin[2] - rayOrigin[2]) / rayDir[2];
-    float tzMax = (boxMax[2] - rayOrigin[2]) / rayDir[2];
-    
-    if (tzMin > tzMax) {
-        float temp = tzMin;
-        tzMin = tzMax;
-        tzMax = temp;
-    }
-    
-    if (tMin > tzMax || tzMin > tMax) return false;
-    
-    if (tzMin > tMin) tMin = tzMin;
-    if (tzMax < tMax) tMax = tzMax;
-    
-    distance = tMin > 0 ? tMin : tMax;
-    return distance > 0;
-}
-
 void SceneViewportWindow::ScreenToWorldRay(float screenX, float screenY, float* rayOrigin, float* rayDir, const float* view, const float* projection) {
     float normalizedX = (2.0f * screenX) / framebufferWidth - 1.0f;
     float normalizedY = 1.0f - (2.0f * screenY) / framebufferHeight;
@@ -466,7 +394,7 @@ void SceneViewportWindow::CreateGridGeometry() {
     glGenBuffers(1, &gridVBO);
     glGenBuffers(1, &gridEBO);
     
-    glBindVertexArray(gridVAO);
+    GLState::Instance().BindVertexArray(gridVAO);
     
     glBindBuffer(GL_ARRAY_BUFFER, gridVBO);
     glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
@@ -476,32 +404,31 @@ void SceneViewportWindow::CreateGridGeometry() {
     
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
-    
-    glBindVertexArray(0);
 }
 
 void SceneViewportWindow::CreateFramebuffer(int width, int height) {
     framebufferWidth = width;
     framebufferHeight = height;
     
+    GLState& state = GLState::Instance();
     glGenFramebuffers(1, &framebuffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    state.BindFramebuffer(framebuffer);
     
     glGenTextures(1, &colorTexture);
-    glBindTexture(GL_TEXTURE_2D, colorTexture);
+    state.BindTexture(0, GL_TEXTURE_2D, colorTexture);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
     
     glGenTextures(1, &depthTexture);
-    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    state.BindTexture(0, GL_TEXTURE_2D, depthTexture);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
     
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    state.BindFramebuffer(0);
 }
 
 void SceneViewportWindow::ResizeFramebuffer(int width, int height) {
@@ -510,27 +437,19 @@ void SceneViewportWindow::ResizeFramebuffer(int width, int height) {
     framebufferWidth = width;
     framebufferHeight = height;
     
-    glBindTexture(GL_TEXTURE_2D, colorTexture);
+    GLState::Instance().BindTexture(0, GL_TEXTURE_2D, colorTexture);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
     
-    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    GLState::Instance().BindTexture(0, GL_TEXTURE_2D, depthTexture);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
 }
 
-void SceneViewportWindow::perspective(float fovy, float aspect, float zNear, float zFar, float* result) {
-    float f = 1.0f / tan(fovy * 3.14159265359f / 360.0f);
-    result[0] = f / aspect; result[4] = 0; result[8] = 0; result[12] = 0;
-    result[1] = 0; result[5] = f; result[9] = 0; result[13] = 0;
-    result[2] = 0; result[6] = 0; result[10] = (zFar + zNear) / (zNear - zFar); result[14] = (2 * zFar * zNear) / (zNear - zFar);
-    result[3] = 0; result[7] = 0; result[11] = -1; result[15] = 0;
-}
-
 SceneViewportWindow::~SceneViewportWindow() {
-    if (gridVAO) glDeleteVertexArrays(1, &gridVAO);
+    if (gridVAO) GLState::Instance().DeleteVertexArray(gridVAO);
     if (gridVBO) glDeleteBuffers(1, &gridVBO);
     if (gridEBO) glDeleteBuffers(1, &gridEBO);
-    if (framebuffer) glDeleteFramebuffers(1, &framebuffer);
-    if (colorTexture) glDeleteTextures(1, &colorTexture);
-    if (depthTexture) glDeleteTextures(1, &depthTexture);
+    if (framebuffer) GLState::Instance().DeleteFramebuffer(framebuffer);
+    if (colorTexture) GLState::Instance().DeleteTexture(colorTexture);
+    if (depthTexture) GLState::Instance().DeleteTexture(depthTexture);
     delete gridShader;
 }
\ No newline at end of file
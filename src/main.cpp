@@ -1,7 +1,10 @@
 #include <iostream>
+#include <string>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
-#include "Game.h"
+#include "game.h"
+#include "ProgramCache.h"
+#include "GLState.h"
 
 const unsigned int SCREEN_WIDTH = 320;
 const unsigned int SCREEN_HEIGHT = 240;
@@ -19,7 +22,7 @@ int currentScreenWidth = SCREEN_WIDTH * WINDOW_SCALE;
 int currentScreenHeight = SCREEN_HEIGHT * WINDOW_SCALE;
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
-    glViewport(0, 0, width, height);
+    GLState::Instance().Viewport(0, 0, width, height);
     game.renderer.SetAspectRatio((float)width / (float)height);
     currentScreenWidth = width;
     currentScreenHeight = height;
@@ -65,9 +68,9 @@ void processInput(GLFWwindow* window) {
         tabPressed = false;
     }
     
-    // Only process player input in camera mode
+    // Only process hotkeys in camera mode
     if (!uiMode) {
-        game.ProcessInput(window, deltaTime);
+        game.ProcessInput(window);
     }
     
     // Fullscreen toggle works in both modes
@@ -101,7 +104,16 @@ void processInput(GLFWwindow* window) {
     }
 }
 
-int main() {
+int main(int argc, char** argv) {
+    std::string recordPath, replayPath;
+    for (int i = 1; i + 1 < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--record") recordPath = argv[++i];
+        else if (arg == "--replay") replayPath = argv[++i];
+    }
+    
+    TraceRecorder::Instance().SetThreadName("Main");
+    
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW" << std::endl;
         return -1;
@@ -136,8 +148,10 @@ int main() {
         return -1;
     }
 
-    glViewport(0, 0, SCREEN_WIDTH * WINDOW_SCALE, SCREEN_HEIGHT * WINDOW_SCALE);
-    glEnable(GL_DEPTH_TEST);
+    ProgramCache::Instance().Initialize((GLADloadproc)glfwGetProcAddress);
+
+    GLState::Instance().Viewport(0, 0, SCREEN_WIDTH * WINDOW_SCALE, SCREEN_HEIGHT * WINDOW_SCALE);
+    GLState::Instance().SetDepthTest(true);
     glDisable(GL_DITHER);
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     
@@ -149,18 +163,32 @@ int main() {
     std::cout << "  Left Shift - Run" << std::endl;
     std::cout << "  H - Toggle head bob" << std::endl;
     std::cout << "  TAB - Toggle UI mode" << std::endl;
+    std::cout << "  F8 - Write trace.json (last 10s)" << std::endl;
+    std::cout << "  F9 - Record input / F10 - Replay input" << std::endl;
 
     if (!game.Initialize(window)) {
         std::cerr << "Failed to initialize game" << std::endl;
         return -1;
     }
 
+    ProgramCache& programCache = ProgramCache::Instance();
+    if (programCache.IsAvailable()) {
+        std::cout << "Program cache: " << programCache.hits << " hits, " << programCache.misses << " compiled" << std::endl;
+    }
+    
+    if (!replayPath.empty()) {
+        game.StartInputReplay(replayPath);
+    } else if (!recordPath.empty()) {
+        game.StartInputRecording(recordPath);
+    }
+
     while (!glfwWindowShouldClose(window)) {
         float currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
 
         processInput(window);
+        deltaTime = game.ProcessPlayerInput(window, deltaTime, !uiMode);
         game.Update(deltaTime);
         game.Render(currentScreenWidth, currentScreenHeight);
 
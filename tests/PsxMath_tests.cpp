@@ -0,0 +1,138 @@
+// SIMD routines in PsxMath.h against their scalar twins (and SinCos4 against libm)
+#include "PsxMath.h"
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+static int failures = 0;
+
+static bool near(float a, float b, float tolerance) {
+    float scale = fabsf(a) > 1.0f ? fabsf(a) : 1.0f;
+    return fabsf(a - b) <= tolerance * scale;
+}
+
+static void check(bool ok, const char* test, int iteration, int index, float got, float expected) {
+    if (ok) return;
+    if (failures++ < 20) {
+        std::printf("FAIL %s #%d [%d]: got %.9g expected %.9g\n", test, iteration, index, got, expected);
+    }
+}
+
+static mat4 randomMatrix(std::mt19937& rng) {
+    std::uniform_real_distribution<float> value(-10.0f, 10.0f);
+    mat4 result;
+    for (int i = 0; i < 16; i++) result.m[i] = value(rng);
+    return result;
+}
+
+// Rotation, translation and scale, as the scene builds them
+static mat4 randomAffine(std::mt19937& rng) {
+    std::uniform_real_distribution<float> angle(-3.14159f, 3.14159f), offset(-100.0f, 100.0f), scale(-4.0f, 4.0f);
+    return Mat4FromTRS(vec3(offset(rng), offset(rng), offset(rng)),
+                       QuatFromEuler(angle(rng), angle(rng), angle(rng)),
+                       vec3(scale(rng), scale(rng), scale(rng)));
+}
+
+static void testMat4Multiply(std::mt19937& rng) {
+    for (int i = 0; i < 1000; i++) {
+        mat4 a = randomMatrix(rng), b = randomMatrix(rng);
+        mat4 simd = Mat4Multiply(a, b), scalar = Mat4MultiplyScalar(a, b);
+        for (int k = 0; k < 16; k++) {
+            check(near(simd.m[k], scalar.m[k], 1e-5f), "Mat4Multiply", i, k, simd.m[k], scalar.m[k]);
+        }
+    }
+}
+
+static void testTransformPoints(std::mt19937& rng) {
+    std::uniform_real_distribution<float> value(-50.0f, 50.0f);
+    for (int i = 0; i < 100; i++) {
+        mat4 m = randomAffine(rng);
+        size_t count = 1 + i % 37; // odd counts too
+        std::vector<vec3> points(count), simd(count), scalar(count);
+        for (auto& p : points) p = vec3(value(rng), value(rng), value(rng));
+
+        TransformPoints(m, points.data(), simd.data(), count);
+        TransformPointsScalar(m, points.data(), scalar.data(), count);
+        for (size_t k = 0; k < count; k++) {
+            check(near(simd[k].x, scalar[k].x, 1e-5f), "TransformPoints.x", i, (int)k, simd[k].x, scalar[k].x);
+            check(near(simd[k].y, scalar[k].y, 1e-5f), "TransformPoints.y", i, (int)k, simd[k].y, scalar[k].y);
+            check(near(simd[k].z, scalar[k].z, 1e-5f), "TransformPoints.z", i, (int)k, simd[k].z, scalar[k].z);
+        }
+
+        // In place, as the header allows
+        std::vector<vec3> inPlace = points;
+        TransformPoints(m, inPlace.data(), inPlace.data(), count);
+        for (size_t k = 0; k < count; k++) {
+            check(near(inPlace[k].x, scalar[k].x, 1e-5f), "TransformPoints in place", i, (int)k, inPlace[k].x, scalar[k].x);
+        }
+    }
+}
+
+static void testTransformAABB(std::mt19937& rng) {
+    std::uniform_real_distribution<float> value(-20.0f, 20.0f), extent(0.0f, 10.0f);
+    for (int i = 0; i < 1000; i++) {
+        mat4 m = randomAffine(rng);
+        float localMin[3], localMax[3];
+        for (int k = 0; k < 3; k++) {
+            localMin[k] = value(rng);
+            localMax[k] = localMin[k] + extent(rng);
+        }
+        float simdMin[3], simdMax[3], scalarMin[3], scalarMax[3];
+        TransformAABB(localMin, localMax, m.m, simdMin, simdMax);
+        TransformAABBScalar(localMin, localMax, m.m, scalarMin, scalarMax);
+        for (int k = 0; k < 3; k++) {
+            check(near(simdMin[k], scalarMin[k], 1e-5f), "TransformAABB.min", i, k, simdMin[k], scalarMin[k]);
+            check(near(simdMax[k], scalarMax[k], 1e-5f), "TransformAABB.max", i, k, simdMax[k], scalarMax[k]);
+        }
+    }
+}
+
+#ifdef PSX_MATH_SSE
+static void sinCos(const float* angles, int iteration) {
+    alignas(16) float sines[4], cosines[4];
+    __m128 s, c;
+    SinCos4(_mm_loadu_ps(angles), s, c);
+    _mm_store_ps(sines, s);
+    _mm_store_ps(cosines, c);
+    for (int k = 0; k < 4; k++) {
+        check(fabsf(sines[k] - sinf(angles[k])) <= 2e-6f, "SinCos4.sin", iteration, k, sines[k], sinf(angles[k]));
+        check(fabsf(cosines[k] - cosf(angles[k])) <= 2e-6f, "SinCos4.cos", iteration, k, cosines[k], cosf(angles[k]));
+    }
+}
+
+static void testSinCos4(std::mt19937& rng) {
+    // Both sides of every quadrant boundary over several turns, negative angles included
+    int iteration = 0;
+    for (int quadrant = -12; quadrant <= 12; quadrant++) {
+        float base = quadrant * 1.57079632679f;
+        float angles[4] = {base - 0.7f, base - 0.01f, base + 0.01f, base + 0.7f};
+        sinCos(angles, iteration++);
+    }
+
+    std::uniform_real_distribution<float> angle(-20.0f, 20.0f);
+    for (int i = 0; i < 10000; i++) {
+        float angles[4] = {angle(rng), angle(rng), angle(rng), angle(rng)};
+        sinCos(angles, iteration++);
+    }
+}
+#endif
+
+int main() {
+    std::mt19937 rng(12345);
+    testMat4Multiply(rng);
+    testTransformPoints(rng);
+    testTransformAABB(rng);
+#ifdef PSX_MATH_SSE
+    testSinCos4(rng);
+#else
+    std::printf("SSE disabled: SinCos4 not built, SIMD paths are the scalar ones\n");
+#endif
+
+    if (failures) {
+        std::printf("%d PsxMath checks failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    std::printf("PsxMath tests passed\n");
+    return EXIT_SUCCESS;
+}